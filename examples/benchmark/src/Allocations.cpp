@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "Allocations.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+
+std::atomic<std::size_t> allocationCount(0);
+
+
+void* countedAllocate(std::size_t size)
+{
+    ++allocationCount;
+
+    if (void* pointer = std::malloc(size == 0 ? 1 : size))
+    {
+        return pointer;
+    }
+
+    throw std::bad_alloc();
+}
+
+
+} // namespace
+
+
+std::size_t numAllocations()
+{
+    return allocationCount;
+}
+
+
+void* operator new(std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+
+void* operator new[](std::size_t size)
+{
+    return countedAllocate(size);
+}
+
+
+void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete[](void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
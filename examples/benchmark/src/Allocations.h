@@ -0,0 +1,19 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstddef>
+
+
+/// \brief Get the number of global operator new calls so far.
+///
+/// This app replaces the global operator new and delete to count them.
+///
+/// \returns the number of allocations made by this process.
+std::size_t numAllocations();
@@ -0,0 +1,43 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+
+/// \brief Time a function over a number of iterations.
+/// \param iterations The number of times to call the function.
+/// \param function The function to call with the iteration index.
+/// \returns the mean time per iteration in nanoseconds.
+template <typename Function>
+double measureNanoseconds(std::size_t iterations, Function function)
+{
+    auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < iterations; ++i)
+    {
+        function(i);
+    }
+
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+
+/// \brief Print a single benchmark result.
+/// \param name The name of the measurement.
+/// \param value The measured value.
+/// \param unit The unit of the value.
+inline void report(const std::string& name, double value, const std::string& unit = "ns/op")
+{
+    std::cout << "  " << name << ": " << value << " " << unit << std::endl;
+}
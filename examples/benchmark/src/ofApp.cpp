@@ -0,0 +1,669 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofApp.h"
+#include <random>
+#include "ofx/DOM/ShapeKernels.h"
+#include "Allocations.h"
+#include "Benchmark.h"
+
+
+namespace {
+
+
+/// \brief Counts the pointer events received by each Element.
+class Listener: public ofxDOM::Element
+{
+public:
+    Listener(): ofxDOM::Element(0, 0, 100, 100)
+    {
+        for (auto* event : { &pointerDown, &pointerMove, &pointerUp })
+        {
+            addEventListener(*event, &Listener::onPointerEvent, false);
+            addEventListener(*event, &Listener::onPointerEvent, true);
+        }
+    }
+
+    void onPointerEvent(ofxDOM::PointerUIEventArgs&)
+    {
+        ++numEvents;
+    }
+
+    std::size_t numEvents = 0;
+
+};
+
+
+/// \brief Build a tree of Elements.
+///
+/// Unrelated allocations are interleaved with the Elements, as they would be
+/// when Elements create their own state.
+///
+/// \param document The Document to add the tree to.
+/// \param numParents The number of children of the Document.
+/// \param numChildren The number of children of each of those children.
+/// \param clutter Storage for the unrelated allocations.
+/// \param leaves The leaf Elements, in the order they were created.
+void buildTree(ofxDOM::Document& document,
+               std::size_t numParents,
+               std::size_t numChildren,
+               std::vector<std::unique_ptr<std::string>>& clutter,
+               std::vector<ofxDOM::Element*>& leaves)
+{
+    for (std::size_t i = 0; i < numParents; ++i)
+    {
+        std::vector<std::unique_ptr<ofxDOM::Element>> children;
+
+        for (std::size_t j = 0; j < numChildren; ++j)
+        {
+            children.push_back(std::make_unique<ofxDOM::Element>(0, 0, 1, 1));
+            leaves.push_back(children.back().get());
+            clutter.push_back(std::make_unique<std::string>(64, 'x'));
+        }
+
+        auto parent = std::make_unique<ofxDOM::Element>(0, 0, 1, 1);
+        parent->addChildren(std::move(children));
+        document.addChild(std::move(parent));
+    }
+}
+
+
+/// \brief A Document that exposes its hit test and child shape cache.
+class HitTestDocument: public ofxDOM::Document
+{
+public:
+    using ofxDOM::Document::recursiveHitTest;
+    using ofxDOM::Document::invalidateChildShape;
+
+};
+
+
+ofx::PointerEventArgs makePointerEvent(const std::string& type,
+                                       std::size_t id,
+                                       const std::string& deviceType,
+                                       int buttons,
+                                       const glm::vec2& position = glm::vec2(50, 50))
+{
+    return ofx::PointerEventArgs(nullptr,
+                                 type,
+                                 0,
+                                 0,
+                                 ofx::Point(position),
+                                 id,
+                                 0,
+                                 0,
+                                 0,
+                                 deviceType,
+                                 deviceType == ofx::PointerEventArgs::TYPE_MOUSE,
+                                 false,
+                                 false,
+                                 true,
+                                 0,
+                                 buttons,
+                                 0,
+                                 {},
+                                 {});
+}
+
+
+} // namespace
+
+
+void ofApp::setup()
+{
+    benchmarkScreenPosition();
+    benchmarkConstruction();
+    benchmarkTree();
+    benchmarkHitTest();
+    benchmarkEventDispatch();
+    benchmarkAttributes();
+    checkDispatchAllocations();
+    checkInjectionAllocations();
+}
+
+
+void ofApp::draw()
+{
+    ofBackgroundGradient(ofColor::white, ofColor::black);
+    ofDrawBitmapStringHighlight("See console for output.", 30, 30);
+}
+
+
+void ofApp::benchmarkScreenPosition()
+{
+    std::cout << "Screen position" << std::endl;
+
+    for (std::size_t depth : { 8, 64, 512 })
+    {
+        ofxDOM::Document document;
+
+        ofxDOM::Element* leaf = &document;
+
+        for (std::size_t i = 0; i < depth; ++i)
+        {
+            leaf = leaf->addChild<ofxDOM::Element>(1, 1, 10, 10);
+        }
+
+        ofxDOM::Element* root = document.children().front();
+
+        float sum = 0;
+
+        double cached = measureNanoseconds(1000000, [&](std::size_t) {
+            sum += leaf->localToScreen(glm::vec2(1, 1)).x;
+        });
+
+        // Moving the root invalidates the whole chain.
+        double invalidated = measureNanoseconds(10000, [&](std::size_t i) {
+            root->setPosition(float(i % 2), 1);
+            sum += leaf->localToScreen(glm::vec2(1, 1)).x;
+        });
+
+        report("depth " + std::to_string(depth) + " cached localToScreen", cached);
+        report("depth " + std::to_string(depth) + " move root + localToScreen", invalidated);
+
+        if (sum == 0)
+        {
+            std::cout << "Unexpected result." << std::endl;
+        }
+    }
+}
+
+
+void ofApp::benchmarkConstruction()
+{
+    std::cout << "Construction" << std::endl;
+
+    report("sizeof(Element)", sizeof(ofxDOM::Element), "bytes");
+
+    double standalone = measureNanoseconds(100000, [&](std::size_t) {
+        std::unique_ptr<ofxDOM::Element> element = std::make_unique<ofxDOM::Element>(0, 0, 10, 10);
+    });
+
+    report("create and destroy an Element", standalone);
+
+    for (std::size_t numChildren : { 100, 10000 })
+    {
+        double added = measureNanoseconds(10, [&](std::size_t) {
+            ofxDOM::Document document;
+
+            for (std::size_t i = 0; i < numChildren; ++i)
+            {
+                document.addChild<ofxDOM::Element>(0, 0, 10, 10);
+            }
+        });
+
+        // Each addChild() notifies every existing sibling, so a bulk insert
+        // is cheaper for large trees.
+        double bulk = measureNanoseconds(10, [&](std::size_t) {
+            ofxDOM::Document document;
+
+            std::vector<std::unique_ptr<ofxDOM::Element>> children;
+
+            for (std::size_t i = 0; i < numChildren; ++i)
+            {
+                children.push_back(std::make_unique<ofxDOM::Element>(0, 0, 10, 10));
+            }
+
+            document.addChildren(std::move(children));
+        });
+
+        report("addChild " + std::to_string(numChildren) + " children, per child", added / numChildren);
+        report("addChildren " + std::to_string(numChildren) + " children, per child", bulk / numChildren);
+    }
+}
+
+
+void ofApp::benchmarkTree()
+{
+    std::cout << "Tree" << std::endl;
+
+    const std::size_t numParents = 1000;
+    const std::size_t numChildren = 100;
+    const std::size_t numElements = numParents * (numChildren + 1);
+    const std::size_t numRounds = 3;
+
+    double build = 0;
+    double traverse = 0;
+    double destroy = 0;
+
+    float sum = 0;
+
+    for (std::size_t round = 0; round < numRounds; ++round)
+    {
+        auto document = std::make_unique<ofxDOM::Document>();
+        std::vector<std::unique_ptr<std::string>> clutter;
+        std::vector<ofxDOM::Element*> leaves;
+
+        build += measureNanoseconds(1, [&](std::size_t) {
+            buildTree(*document, numParents, numChildren, clutter, leaves);
+        });
+
+        // Visit each leaf and its parent, as a layout pass would.
+        traverse += measureNanoseconds(10, [&](std::size_t) {
+            for (ofxDOM::Element* leaf : leaves)
+            {
+                sum += leaf->getWidth() + leaf->parent()->getWidth();
+            }
+        });
+
+        destroy += measureNanoseconds(1, [&](std::size_t) {
+            document.reset();
+        });
+    }
+
+    report("build, per Element", build / numRounds / numElements);
+    report("traverse, per Element", traverse / numRounds / numElements);
+    report("destroy, per Element", destroy / numRounds / numElements);
+
+    if (sum == 0)
+    {
+        std::cout << "Unexpected result." << std::endl;
+    }
+}
+
+
+void ofApp::benchmarkHitTest()
+{
+    std::cout << "Hit test (" << ofxDOM::ShapeKernels::instructionSet() << ")" << std::endl;
+
+    for (std::size_t numChildren : { 100, 1000, 10000, 100000 })
+    {
+        HitTestDocument document;
+        document.setAutoFillScreen(false);
+
+        // Lay the children out in a square grid of 10 x 10 cells.
+        std::size_t numColumns = std::size_t(std::ceil(std::sqrt(double(numChildren))));
+        float size = numColumns * 10.0f;
+
+        document.setSize(size, size);
+
+        std::vector<std::unique_ptr<ofxDOM::Element>> children;
+
+        for (std::size_t i = 0; i < numChildren; ++i)
+        {
+            children.push_back(std::make_unique<ofxDOM::Element>((i % numColumns) * 10.0f,
+                                                                 (i / numColumns) * 10.0f,
+                                                                 8,
+                                                                 8));
+        }
+
+        std::vector<ofxDOM::Element*> childPointers = document.addChildren(std::move(children));
+
+        // Use the same positions on every run.
+        std::minstd_rand random(0);
+        std::uniform_real_distribution<float> coordinate(0, size);
+
+        std::vector<ofxDOM::Position> positions;
+
+        for (std::size_t i = 0; i < 1024; ++i)
+        {
+            positions.push_back(ofxDOM::Position(coordinate(random), coordinate(random)));
+        }
+
+        std::size_t numIterations = std::max(std::size_t(100), std::size_t(1000000) / numChildren);
+        std::size_t numHits = 0;
+
+        // The loop hit testing used before the packed scan.
+        double objects = measureNanoseconds(numIterations, [&](std::size_t i) {
+            const ofxDOM::Position& position = positions[i % positions.size()];
+
+            for (ofxDOM::Element* child : childPointers)
+            {
+                if (child->getTotalShape().inside(position))
+                {
+                    ++numHits;
+                    break;
+                }
+            }
+        });
+
+        double packed = measureNanoseconds(numIterations, [&](std::size_t i) {
+            if (document.recursiveHitTest(positions[i % positions.size()]) != &document)
+            {
+                ++numHits;
+            }
+        });
+
+        document.setSpatialIndexEnabled(true);
+
+        double indexed = measureNanoseconds(numIterations, [&](std::size_t i) {
+            if (document.recursiveHitTest(positions[i % positions.size()]) != &document)
+            {
+                ++numHits;
+            }
+        });
+
+        // Raise a child, as a click on a window would, then hit test. The
+        // spatial index is reordered in place rather than rebuilt.
+        std::uniform_int_distribution<std::size_t> childIndex(0, numChildren - 1);
+
+        double raised = measureNanoseconds(numIterations, [&](std::size_t i) {
+            childPointers[childIndex(random)]->moveToFront();
+
+            if (document.recursiveHitTest(positions[i % positions.size()]) != &document)
+            {
+                ++numHits;
+            }
+        });
+
+        document.setSpatialIndexEnabled(false);
+
+        double childShape = measureNanoseconds(100, [&](std::size_t) {
+            document.invalidateChildShape();
+            numHits += document.getChildShape().width > 0;
+        });
+
+        // A frame of touch moves, found in one traversal or one at a time.
+        const std::size_t numPointers = 60;
+
+        std::vector<ofx::PointerEventArgs> batch;
+
+        for (std::size_t i = 0; i < numPointers; ++i)
+        {
+            batch.push_back(makePointerEvent(ofx::PointerEventArgs::POINTER_MOVE,
+                                             100 + i,
+                                             ofx::PointerEventArgs::TYPE_TOUCH,
+                                             1,
+                                             positions[i]));
+        }
+
+        std::size_t numBatchIterations = std::max(std::size_t(10), std::size_t(100000) / numChildren);
+
+        double batched = measureNanoseconds(numBatchIterations, [&](std::size_t) {
+            document.onPointerEvents(batch);
+        });
+
+        double unbatched = measureNanoseconds(numBatchIterations, [&](std::size_t) {
+            for (ofx::PointerEventArgs& e : batch)
+            {
+                document.onPointerEvent(e);
+            }
+        });
+
+        std::string name = std::to_string(numChildren) + " children, ";
+
+        report(name + "scan child objects", objects);
+        report(name + "packed scan", packed);
+        report(name + "spatial index", indexed);
+        report(name + "spatial index, raise and hit test", raised);
+        report(name + "child shape update", childShape);
+        report(name + std::to_string(numPointers) + " pointers, onPointerEvents()", batched);
+        report(name + std::to_string(numPointers) + " pointers, onPointerEvent() each", unbatched);
+
+        if (numHits == 0)
+        {
+            std::cout << "Unexpected result." << std::endl;
+        }
+    }
+}
+
+
+void ofApp::benchmarkEventDispatch()
+{
+    std::cout << "Event dispatch" << std::endl;
+
+    ofxDOM::DOMEvent<ofxDOM::PointerUIEventArgs> pointerEvent;
+    ofxDOM::DOMEvent<ofxDOM::FocusEventArgs> focusEvent;
+
+    // Alternate the types so that neither check is always true.
+    std::vector<ofxDOM::BaseDOMEvent*> events;
+
+    for (std::size_t i = 0; i < 1024; ++i)
+    {
+        events.push_back(i % 2 ? static_cast<ofxDOM::BaseDOMEvent*>(&pointerEvent) : &focusEvent);
+    }
+
+    typedef ofxDOM::DOMEvent<ofxDOM::PointerUIEventArgs> PointerDOMEvent;
+
+    std::size_t numMatches = 0;
+
+    double dynamicCast = measureNanoseconds(10000000, [&](std::size_t i) {
+        if (dynamic_cast<PointerDOMEvent*>(events[i % events.size()]) != nullptr)
+        {
+            ++numMatches;
+        }
+    });
+
+    double tagCheck = measureNanoseconds(10000000, [&](std::size_t i) {
+        if (events[i % events.size()]->argsType() == PointerDOMEvent::argsTypeTag())
+        {
+            ++numMatches;
+        }
+    });
+
+    report("dynamic_cast to DOMEvent<>", dynamicCast);
+    report("argument type tag check", tagCheck);
+
+    ofxDOM::Document document;
+    document.setAutoFillScreen(false);
+    document.setSize(100, 100);
+
+    ofxDOM::Element* leaf = &document;
+
+    for (std::size_t i = 1; i < ofxDOM::Document::INLINE_PATH_CAPACITY; ++i)
+    {
+        leaf = leaf->addChild<Listener>();
+    }
+
+    ofx::PointerEventArgs move = makePointerEvent(ofx::PointerEventArgs::POINTER_MOVE,
+                                                  1,
+                                                  ofx::PointerEventArgs::TYPE_MOUSE,
+                                                  0);
+
+    // Enter the tree first, so that only pointermove is dispatched.
+    document.onPointerEvent(move);
+
+    double dispatch = measureNanoseconds(100000, [&](std::size_t) {
+        document.onPointerEvent(move);
+    });
+
+    std::size_t numTargets = ofxDOM::Document::INLINE_PATH_CAPACITY;
+
+    report("pointermove through " + std::to_string(numTargets) + " targets", dispatch);
+    report("pointermove per target", dispatch / numTargets);
+
+    if (numMatches == 0)
+    {
+        std::cout << "Unexpected result." << std::endl;
+    }
+}
+
+
+void ofApp::benchmarkAttributes()
+{
+    std::cout << "Attributes" << std::endl;
+
+    for (std::size_t numAttributes : { 2, 16 })
+    {
+        ofxDOM::Document document;
+        ofxDOM::Element* element = document.addChild<ofxDOM::Element>(0, 0, 10, 10);
+
+        std::vector<std::string> names;
+
+        for (std::size_t i = 0; i < numAttributes; ++i)
+        {
+            names.push_back("attribute" + std::to_string(i));
+            element->setAttribute(names.back(), float(i));
+        }
+
+        const std::string text = "a value too long to be stored inline";
+        const std::string missing = "missing";
+
+        const std::size_t numIterations = 1000000;
+        float sum = 0;
+
+        std::size_t before = numAllocations();
+
+        double setNumber = measureNanoseconds(numIterations, [&](std::size_t i) {
+            element->setAttribute(names[i % numAttributes], float(i));
+        });
+
+        std::size_t numberAllocations = numAllocations() - before;
+
+        double setText = measureNanoseconds(numIterations, [&](std::size_t i) {
+            element->setAttribute(names[i % numAttributes], text);
+        });
+
+        for (std::size_t i = 0; i < numAttributes; ++i)
+        {
+            element->setAttribute(names[i], float(i));
+        }
+
+        double getNumber = measureNanoseconds(numIterations, [&](std::size_t i) {
+            sum += element->getAttribute<float>(names[i % numAttributes]);
+        });
+
+        double hasMissing = measureNanoseconds(numIterations, [&](std::size_t) {
+            sum += element->hasAttribute(missing);
+        });
+
+        std::string name = std::to_string(numAttributes) + " attributes, ";
+
+        report(name + "setAttribute(float)", setNumber);
+        report(name + "setAttribute(std::string)", setText);
+        report(name + "getAttribute<float>()", getNumber);
+        report(name + "hasAttribute() when missing", hasMissing);
+        report(name + "allocations per setAttribute(float)", double(numberAllocations) / numIterations, "");
+
+        if (sum == 0)
+        {
+            std::cout << "Unexpected result." << std::endl;
+        }
+    }
+}
+
+
+void ofApp::checkDispatchAllocations()
+{
+    const std::size_t numIterations = 1000;
+
+    // Touch pointers get a new id for each contact.
+    std::vector<ofx::PointerEventArgs> events;
+
+    for (std::size_t i = 0; i < numIterations + 1; ++i)
+    {
+        const std::string& touch = ofx::PointerEventArgs::TYPE_TOUCH;
+        const std::string& mouse = ofx::PointerEventArgs::TYPE_MOUSE;
+
+        events.push_back(makePointerEvent(ofx::PointerEventArgs::POINTER_DOWN, 100 + i, touch, 1));
+        events.push_back(makePointerEvent(ofx::PointerEventArgs::POINTER_MOVE, 100 + i, touch, 1));
+        events.push_back(makePointerEvent(ofx::PointerEventArgs::POINTER_UP, 100 + i, touch, 0));
+        events.push_back(makePointerEvent(ofx::PointerEventArgs::POINTER_MOVE, 1, mouse, 0));
+    }
+
+    const std::size_t numEventsPerFrame = 4;
+
+    for (bool queued : { false, true })
+    {
+        std::cout << "Dispatch allocations" << (queued ? ", queued" : "") << std::endl;
+
+        ofxDOM::Document document;
+        document.setAutoFillScreen(false);
+        document.setSize(100, 100);
+        document.setEventQueueing(queued);
+
+        ofxDOM::Element* leaf = &document;
+
+        // The Document is the last target on the path.
+        for (std::size_t i = 1; i < ofxDOM::Document::INLINE_PATH_CAPACITY; ++i)
+        {
+            leaf = leaf->addChild<Listener>();
+        }
+
+        ofEventArgs args;
+
+        // Queued events are dispatched by the next update. Each frame is
+        // followed by a frame without input.
+        auto dispatchFrame = [&](std::size_t first) {
+            for (std::size_t i = first; i < first + numEventsPerFrame; ++i)
+            {
+                document.onPointerEvent(events[i]);
+            }
+
+            if (queued)
+            {
+                document.update(args);
+                document.update(args);
+            }
+        };
+
+        // The first iterations create the storage for each active pointer.
+        for (std::size_t i = 0; i < 8; i += numEventsPerFrame)
+        {
+            dispatchFrame(i);
+        }
+
+        std::size_t numNotifications = 0;
+
+        for (ofxDOM::Element* element = leaf; element != &document; element = element->parent())
+        {
+            numNotifications -= static_cast<Listener*>(element)->numEvents;
+        }
+
+        std::size_t before = numAllocations();
+
+        for (std::size_t i = 8; i < events.size(); i += numEventsPerFrame)
+        {
+            dispatchFrame(i);
+        }
+
+        std::size_t allocations = numAllocations() - before;
+
+        for (ofxDOM::Element* element = leaf; element != &document; element = element->parent())
+        {
+            numNotifications += static_cast<Listener*>(element)->numEvents;
+        }
+
+        // ofEvent::notify() copies its listener list, which allocates once
+        // for each notified ofEvent. Each ofEvent here has a single listener.
+        std::size_t numDispatches = events.size() - 8;
+        std::size_t domAllocations = allocations - numNotifications;
+
+        report("listener notifications per dispatch", double(numNotifications) / numDispatches, "");
+        report("allocations per dispatch", double(allocations) / numDispatches, "");
+        report("allocations per dispatch, excluding ofEvent::notify()", double(domAllocations) / numDispatches, "");
+
+        std::cout << (domAllocations == 0 ? "  PASS" : "  FAIL") << std::endl;
+    }
+}
+
+
+void ofApp::checkInjectionAllocations()
+{
+    std::cout << "Injection allocations" << std::endl;
+
+    ofxDOM::Document document;
+
+    ofx::PointerEventArgs move = makePointerEvent(ofx::PointerEventArgs::POINTER_MOVE,
+                                                  1,
+                                                  ofx::PointerEventArgs::TYPE_MOUSE,
+                                                  0);
+
+    const std::size_t numFrames = 100;
+    const std::size_t numEventsPerFrame = 200;
+
+    std::size_t allocations = 0;
+
+    for (std::size_t frame = 0; frame < numFrames; ++frame)
+    {
+        // Only the pushes are counted, since they are what other threads do.
+        std::size_t before = numAllocations();
+
+        for (std::size_t i = 0; i < numEventsPerFrame; ++i)
+        {
+            document.injectPointerEvent(move);
+        }
+
+        allocations += numAllocations() - before;
+
+        document.flushInjectedEvents();
+    }
+
+    report("allocations per injected event", double(allocations) / (numFrames * numEventsPerFrame), "");
+
+    std::cout << (allocations == 0 ? "  PASS" : "  FAIL") << std::endl;
+}
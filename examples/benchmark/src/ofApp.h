@@ -0,0 +1,64 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include "ofMain.h"
+#include "ofxDOM.h"
+
+
+/// \brief Measures the cost of common Document operations.
+///
+/// Results are printed to the console. Build in release mode for meaningful
+/// numbers.
+class ofApp: public ofBaseApp
+{
+public:
+    void setup() override;
+    void draw() override;
+
+    /// \brief Measure cached screen position queries in a deep tree.
+    void benchmarkScreenPosition();
+
+    /// \brief Measure Element construction and destruction.
+    void benchmarkConstruction();
+
+    /// \brief Measure building, traversing and destroying a large tree.
+    void benchmarkTree();
+
+    /// \brief Measure hit testing and child shape updates for wide trees.
+    ///
+    /// A Document with 100 to 100,000 children is hit tested with the packed
+    /// child scan, with the spatial index, and with a scan of the child
+    /// objects for comparison. A frame of 60 touch moves is dispatched with
+    /// Document::onPointerEvents() and with one onPointerEvent() per move.
+    void benchmarkHitTest();
+
+    /// \brief Measure the cost of resolving and dispatching DOM events.
+    ///
+    /// Compares the argument type tag check used by EventTarget::handleEvent()
+    /// with a dynamic_cast, then dispatches pointer events through a deep tree.
+    void benchmarkEventDispatch();
+
+    /// \brief Measure setting and getting Element attributes.
+    ///
+    /// Elements with a few attributes are searched linearly, while Elements
+    /// with more than AttributeStore::MAX_LINEAR_ATTRIBUTES use an index.
+    void benchmarkAttributes();
+
+    /// \brief Check that pointer event dispatch does not allocate.
+    ///
+    /// Pointer events are dispatched through a tree INLINE_PATH_CAPACITY
+    /// deep with capture and bubble listeners on every Element, both
+    /// directly and through the event queue flushed by Document::update().
+    void checkDispatchAllocations();
+
+    /// \brief Check that injecting events does not allocate.
+    void checkInjectionAllocations();
+
+};
@@ -0,0 +1,94 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "HeapUsage.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+
+namespace {
+
+
+std::atomic<std::size_t> bytesInUse(0);
+
+
+/// \brief The size of the header that records each allocation's size.
+///
+/// This keeps the returned memory aligned for any fundamental type.
+const std::size_t HEADER_SIZE = alignof(std::max_align_t);
+
+
+void* trackedAllocate(std::size_t size)
+{
+    if (void* block = std::malloc(HEADER_SIZE + size))
+    {
+        *static_cast<std::size_t*>(block) = size;
+        bytesInUse += size;
+        return static_cast<char*>(block) + HEADER_SIZE;
+    }
+
+    throw std::bad_alloc();
+}
+
+
+void trackedFree(void* pointer)
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+
+    void* block = static_cast<char*>(pointer) - HEADER_SIZE;
+    bytesInUse -= *static_cast<std::size_t*>(block);
+    std::free(block);
+}
+
+
+} // namespace
+
+
+std::size_t heapBytesInUse()
+{
+    return bytesInUse;
+}
+
+
+void* operator new(std::size_t size)
+{
+    return trackedAllocate(size);
+}
+
+
+void* operator new[](std::size_t size)
+{
+    return trackedAllocate(size);
+}
+
+
+void operator delete(void* pointer) noexcept
+{
+    trackedFree(pointer);
+}
+
+
+void operator delete[](void* pointer) noexcept
+{
+    trackedFree(pointer);
+}
+
+
+void operator delete(void* pointer, std::size_t) noexcept
+{
+    trackedFree(pointer);
+}
+
+
+void operator delete[](void* pointer, std::size_t) noexcept
+{
+    trackedFree(pointer);
+}
@@ -0,0 +1,20 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstddef>
+
+
+/// \brief Get the number of heap bytes currently allocated.
+///
+/// This app replaces the global operator new and delete to track the size of
+/// each allocation. Allocator overhead is not included.
+///
+/// \returns the number of bytes allocated with operator new and not deleted.
+std::size_t heapBytesInUse();
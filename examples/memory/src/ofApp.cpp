@@ -0,0 +1,184 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofApp.h"
+#include <unordered_map>
+#include "HeapUsage.h"
+
+
+namespace {
+
+
+/// \brief The number of Elements created for each measurement.
+const std::size_t NUM_ELEMENTS = 10000;
+
+
+/// \brief A named set of attributes to store on each Element.
+struct AttributeSet
+{
+    std::string name;
+    std::vector<std::pair<std::string, ofxDOM::Any>> attributes;
+};
+
+
+/// \brief Print a single measurement.
+/// \param name The name of the measurement.
+/// \param value The measured value.
+/// \param unit The unit of the value.
+void report(const std::string& name, double value, const std::string& unit = "bytes")
+{
+    std::cout << "  " << name << ": " << value << " " << unit << std::endl;
+}
+
+
+std::vector<AttributeSet> makeAttributeSets()
+{
+    std::vector<AttributeSet> sets;
+
+    sets.push_back({ "no attributes", { } });
+
+    sets.push_back({ "2 inline values", {
+        { "opacity", 0.5f },
+        { "enabled", true }
+    } });
+
+    sets.push_back({ "2 values, one a string", {
+        { "role", std::string("button") },
+        { "enabled", true }
+    } });
+
+    AttributeSet many = { "16 inline values", { } };
+
+    for (std::size_t i = 0; i < 16; ++i)
+    {
+        many.attributes.push_back({ "attribute" + std::to_string(i), float(i) });
+    }
+
+    sets.push_back(many);
+
+    return sets;
+}
+
+
+/// \brief Measure the heap bytes used per Element with a set of attributes.
+/// \param set The attributes to set on each Element.
+/// \param storeBytes The mean AttributeStore::memoryUsage() per Element.
+/// \returns the mean heap bytes per Element, including the Element itself.
+double measureElements(const AttributeSet& set, double& storeBytes)
+{
+    std::vector<std::unique_ptr<ofxDOM::Element>> elements;
+    elements.reserve(NUM_ELEMENTS);
+
+    std::size_t before = heapBytesInUse();
+
+    for (std::size_t i = 0; i < NUM_ELEMENTS; ++i)
+    {
+        elements.push_back(std::make_unique<ofxDOM::Element>(0, 0, 10, 10));
+
+        for (const auto& attribute : set.attributes)
+        {
+            elements.back()->setAttribute(attribute.first, attribute.second);
+        }
+    }
+
+    std::size_t bytes = heapBytesInUse() - before;
+
+    storeBytes = 0;
+
+    for (const auto& element : elements)
+    {
+        storeBytes += element->attributes().memoryUsage();
+    }
+
+    storeBytes /= NUM_ELEMENTS;
+
+    return double(bytes) / NUM_ELEMENTS;
+}
+
+
+/// \brief Measure the bytes used per map holding a set of attributes.
+/// \param set The attributes to store in each map.
+/// \returns the mean bytes per map, including the map itself.
+double measureMaps(const AttributeSet& set)
+{
+    std::vector<std::unordered_map<std::string, ofxDOM::Any>> maps;
+    maps.reserve(NUM_ELEMENTS);
+
+    std::size_t before = heapBytesInUse();
+
+    for (std::size_t i = 0; i < NUM_ELEMENTS; ++i)
+    {
+        maps.emplace_back();
+
+        for (const auto& attribute : set.attributes)
+        {
+            maps.back()[attribute.first] = attribute.second;
+        }
+    }
+
+    std::size_t bytes = heapBytesInUse() - before;
+
+    return double(bytes) / NUM_ELEMENTS + sizeof(maps.front());
+}
+
+
+} // namespace
+
+
+void ofApp::setup()
+{
+    reportTypeSizes();
+    reportElementMemory();
+}
+
+
+void ofApp::draw()
+{
+    ofBackgroundGradient(ofColor::white, ofColor::black);
+    ofDrawBitmapStringHighlight("See console for output.", 30, 30);
+}
+
+
+void ofApp::reportTypeSizes()
+{
+    std::cout << "Type sizes" << std::endl;
+
+    report("sizeof(Element)", sizeof(ofxDOM::Element));
+    report("sizeof(AttributeStore)", sizeof(ofxDOM::AttributeStore));
+    report("sizeof(AttributeStore::Entry)", sizeof(ofxDOM::AttributeStore::Entry));
+    report("sizeof(Any)", sizeof(ofxDOM::Any));
+    report("sizeof(std::unordered_map<std::string, Any>)", sizeof(std::unordered_map<std::string, ofxDOM::Any>));
+}
+
+
+void ofApp::reportElementMemory()
+{
+    std::cout << "Memory per Element (" << NUM_ELEMENTS << " Elements)" << std::endl;
+
+    double emptyElementBytes = 0;
+
+    for (const AttributeSet& set : makeAttributeSets())
+    {
+        double storeBytes = 0;
+        double elementBytes = measureElements(set, storeBytes);
+        double mapBytes = measureMaps(set);
+
+        if (set.attributes.empty())
+        {
+            emptyElementBytes = elementBytes;
+        }
+
+        // The attributes cost what they add to an Element without any, plus
+        // the store embedded in every Element.
+        double attributeBytes = elementBytes - emptyElementBytes + sizeof(ofxDOM::AttributeStore);
+
+        report(set.name + ", Element", elementBytes);
+        report(set.name + ", attributes", attributeBytes);
+        report(set.name + ", AttributeStore::memoryUsage()", storeBytes);
+        report(set.name + ", std::unordered_map<std::string, Any>", mapBytes);
+    }
+}
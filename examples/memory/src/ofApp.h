@@ -0,0 +1,36 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include "ofMain.h"
+#include "ofxDOM.h"
+
+
+/// \brief Reports the memory used by each Element and its attributes.
+///
+/// Results are printed to the console. Heap usage is measured by replacing
+/// the global operator new and delete, so it covers everything an Element
+/// allocates, including attribute values stored on the heap.
+class ofApp: public ofBaseApp
+{
+public:
+    void setup() override;
+    void draw() override;
+
+    /// \brief Report the size of the types that make up an Element.
+    void reportTypeSizes();
+
+    /// \brief Report the memory used per Element for several attribute sets.
+    ///
+    /// Each attribute set is compared with the same attributes stored in an
+    /// std::unordered_map<std::string, Any>, which is how Elements stored
+    /// them before AttributeStore.
+    void reportElementMemory();
+
+};
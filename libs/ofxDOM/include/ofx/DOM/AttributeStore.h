@@ -0,0 +1,199 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include "ofx/DOM/Types.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief An interned attribute name.
+///
+/// Equal names share the same key, so an AttributeStore that scans its
+/// entries compares keys as pointers without touching the characters. A
+/// store large enough to have an index hashes the names instead.
+typedef const std::string* AttributeKey;
+
+
+/// \brief A registry of interned attribute names.
+///
+/// Each name is stored once for the lifetime of the program, no matter how
+/// many Elements use it.
+class AttributeKeyRegistry
+{
+public:
+    /// \brief Get the key for an attribute name, registering it if needed.
+    /// \param name The attribute name.
+    /// \returns the key of the attribute name.
+    static AttributeKey keyForName(const std::string& name);
+
+    /// \brief Get the key for an attribute name without registering it.
+    /// \param name The attribute name.
+    /// \returns the key of the attribute name or nullptr if not registered.
+    static AttributeKey findKey(const std::string& name);
+
+    /// \returns the number of registered attribute names.
+    static std::size_t size();
+
+private:
+    /// \brief Create an empty registry.
+    AttributeKeyRegistry();
+
+    /// \brief Get the shared registry.
+    ///
+    /// The registry is never destroyed, so keys held by Elements that are
+    /// destroyed during static destruction remain valid.
+    ///
+    /// \returns the shared registry.
+    static AttributeKeyRegistry& instance();
+
+    /// \brief The registered names.
+    ///
+    /// Set nodes are never moved, so pointers to the names remain valid.
+    std::unordered_set<std::string> _names;
+
+    /// \brief Attributes may be set on any thread.
+    mutable std::mutex _mutex;
+
+};
+
+
+/// \brief The named attributes of a single Element.
+///
+/// Attributes are kept in a flat vector and found with a linear scan, which
+/// avoids hashing and the per-attribute allocations of a hash table for the
+/// few attributes most Elements have. An Element without attributes allocates
+/// nothing. Once there are more than MAX_LINEAR_ATTRIBUTES, an index from key
+/// to position is added. The index hashes the names rather than the keys, so
+/// lookups by name do not need the AttributeKeyRegistry.
+class AttributeStore
+{
+public:
+    /// \brief A single attribute.
+    struct Entry
+    {
+        /// \brief The interned attribute name.
+        AttributeKey key;
+
+        /// \brief The attribute value.
+        Any value;
+    };
+
+    typedef std::vector<Entry>::const_iterator const_iterator;
+
+    /// \brief The number of attributes found without an index.
+    enum
+    {
+        MAX_LINEAR_ATTRIBUTES = 8
+    };
+
+    /// \brief Create an empty AttributeStore.
+    AttributeStore();
+
+    /// \brief Destroy the AttributeStore.
+    ~AttributeStore();
+
+    /// \returns the number of attributes.
+    std::size_t size() const;
+
+    /// \returns true if there are no attributes.
+    bool empty() const;
+
+    /// \returns an iterator to the first attribute, in no particular order.
+    const_iterator begin() const;
+
+    /// \returns an iterator past the last attribute.
+    const_iterator end() const;
+
+    /// \brief Find an attribute by name.
+    /// \param name The attribute name.
+    /// \returns the attribute value or nullptr if not found.
+    Any* find(const std::string& name);
+
+    /// \brief Find an attribute by name.
+    /// \param name The attribute name.
+    /// \returns the attribute value or nullptr if not found.
+    const Any* find(const std::string& name) const;
+
+    /// \brief Find an attribute by key.
+    /// \param key The interned attribute name.
+    /// \returns the attribute value or nullptr if not found.
+    const Any* find(AttributeKey key) const;
+
+    /// \brief Set an attribute, replacing any existing value.
+    /// \param name The attribute name.
+    /// \param value The attribute value.
+    /// \returns true if the attribute was added, false if it was replaced.
+    bool set(const std::string& name, const Any& value);
+
+    /// \brief Remove an attribute.
+    /// \param name The attribute name.
+    /// \returns true if the attribute was removed, false if not found.
+    bool erase(const std::string& name);
+
+    /// \brief Get the approximate memory used by the attributes.
+    ///
+    /// This includes the store, its entries and its index, but not values
+    /// that Any allocates on the heap.
+    ///
+    /// \returns the size in bytes.
+    std::size_t memoryUsage() const;
+
+private:
+    /// \brief Hash a key by its name.
+    struct NameHash
+    {
+        std::size_t operator () (AttributeKey key) const
+        {
+            return std::hash<std::string>()(*key);
+        }
+    };
+
+    /// \brief Compare two keys by their names.
+    ///
+    /// Either key may point to a name that is not interned.
+    struct NameEqual
+    {
+        bool operator () (AttributeKey left, AttributeKey right) const
+        {
+            return left == right || *left == *right;
+        }
+    };
+
+    typedef std::unordered_map<AttributeKey, std::size_t, NameHash, NameEqual> Index;
+
+    /// \brief Find the position of an attribute by name.
+    /// \param name The attribute name.
+    /// \returns the position or size() if not found.
+    std::size_t _indexOf(const std::string& name) const;
+
+    /// \brief Find the position of an attribute by key.
+    /// \param key The interned attribute name.
+    /// \returns the position or size() if not found.
+    std::size_t _indexOf(AttributeKey key) const;
+
+    /// \brief The attributes, in no particular order.
+    std::vector<Entry> _entries;
+
+    /// \brief The position of each attribute, or nullptr if the attributes
+    /// are few enough to scan.
+    std::unique_ptr<Index> _index;
+
+};
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,130 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <atomic>
+#include "ofx/DOM/EventQueue.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief A lock-free multi-producer single-consumer queue of input events.
+///
+/// Any thread may push events without blocking on other producers or on the
+/// consumer. Only a single thread, usually the main thread, may pop events.
+///
+/// This is an intrusive linked list queue in the style of Dmitry Vyukov's
+/// MPSC queue. A push is a single atomic exchange. Popped nodes are kept on a
+/// lock-free list of spares and reused by later pushes, so once reserve() has
+/// been called or enough events have passed through the queue, a push does
+/// not allocate. A push only allocates when no spare is available, either
+/// because more events are pending than ever before or because another
+/// producer is taking a spare at the same moment. Producers then block only
+/// as long as the allocator does.
+///
+/// Generally this class should not be instantiated directly but instead
+/// events should be added using Document::injectPointerEvent() and
+/// Document::injectKeyEvent().
+class ConcurrentEventQueue
+{
+public:
+    /// \brief Create an empty ConcurrentEventQueue.
+    ConcurrentEventQueue();
+
+    /// \brief Destroy the ConcurrentEventQueue, discarding any entries.
+    ///
+    /// No producer may push while the queue is being destroyed.
+    ~ConcurrentEventQueue();
+
+    ConcurrentEventQueue(const ConcurrentEventQueue&) = delete;
+    ConcurrentEventQueue& operator = (const ConcurrentEventQueue&) = delete;
+
+    /// \brief Add a pointer event to the back of the queue.
+    ///
+    /// This may be called from any thread.
+    ///
+    /// \param e The pointer event to add.
+    void push(const PointerEventArgs& e);
+
+    /// \brief Add a key event to the back of the queue.
+    ///
+    /// This may be called from any thread.
+    ///
+    /// \param e The key event to add.
+    void push(const ofKeyEventArgs& e);
+
+    /// \brief Remove the entry at the front of the queue.
+    ///
+    /// This may only be called from the consumer thread. An entry whose push
+    /// has not yet completed is not visible until it does.
+    ///
+    /// The front entry is copied into the given entry, so that the storage
+    /// of both is kept for reuse.
+    ///
+    /// \param entry The entry to copy the front entry into.
+    /// \returns true if an entry was removed.
+    bool pop(EventQueue::Entry& entry);
+
+    /// \brief Preallocate spare nodes.
+    ///
+    /// This may be called from any thread.
+    ///
+    /// \param count The number of spare nodes to add.
+    void reserve(std::size_t count);
+
+private:
+    /// \brief A single node in the list.
+    struct Node
+    {
+        /// \brief The next node, written by the producer that pushes it.
+        std::atomic<Node*> next;
+
+        /// \brief The next spare node, valid while this node is a spare.
+        Node* nextSpare = nullptr;
+
+        /// \brief The queued event.
+        EventQueue::Entry entry;
+    };
+
+    /// \brief Link a node at the back of the queue.
+    /// \param node The node to link.
+    void _push(Node* node);
+
+    /// \returns a spare node or a new node if there are no spares.
+    Node* _acquireNode();
+
+    /// \brief Add a node to the spares.
+    /// \param node The unlinked node.
+    void _releaseNode(Node* node);
+
+    /// \brief The most recently pushed node, shared by all producers.
+    std::atomic<Node*> _back;
+
+    /// \brief The node before the front entry, owned by the consumer.
+    ///
+    /// This node's entry has already been popped (or is the initial stub).
+    Node* _front = nullptr;
+
+    /// \brief The top of the stack of spare nodes.
+    std::atomic<Node*> _spares;
+
+    /// \brief Set while a producer is taking a spare node.
+    ///
+    /// Only one producer at a time pops the stack of spares, which keeps a
+    /// pop from being fooled by a node that was taken and returned while it
+    /// was reading (the ABA problem). Other producers allocate rather than
+    /// wait.
+    std::atomic_flag _takingSpare = ATOMIC_FLAG_INIT;
+
+};
+
+
+} } // namespace ofx::DOM
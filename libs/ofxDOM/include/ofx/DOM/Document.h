@@ -8,7 +8,14 @@
 #pragma once
 
 
+#include "ofx/DOM/ConcurrentEventQueue.h"
 #include "ofx/DOM/Element.h"
+#include "ofx/DOM/EventQueue.h"
+#include "ofx/DOM/InputRecorder.h"
+#include "ofx/DOM/PointerMap.h"
+#include "ofx/DOM/Selector.h"
+#include <functional>
+#include <unordered_set>
 
 
 namespace ofx {
@@ -56,6 +63,9 @@ public:
     bool fileDragEvent(ofDragInfo& e);
 
     /// \brief Callback for key events events.
+    ///
+    /// If event queueing is enabled, the event is queued and false is returned.
+    ///
     /// \param e the event data.
     /// \returns true iff the event was handled.
     bool onKeyEvent(ofKeyEventArgs& e);
@@ -67,12 +77,194 @@ public:
     /// \returns true if the Document size will always match the screen size.
     bool getAutoFillScreen() const;
 
+    /// \brief Determine if pointer hit tests should be seeded by the last target.
+    ///
+    /// When enabled, the hit test for a pointer event first searches the
+    /// subtree of the last active target for that pointer, moving up to its
+    /// ancestors only as needed. This is much faster for high rate pointer
+    /// move events in large Documents. The result is the same as a full
+    /// search as long as the hit test region of each Element lies within its
+    /// total shape.
+    ///
+    /// \param incrementalHitTesting True if hit tests should be seeded.
+    void setIncrementalHitTesting(bool incrementalHitTesting);
+
+    /// \returns true if pointer hit tests are seeded by the last target.
+    bool getIncrementalHitTesting() const;
+
+    /// \brief Find an Element in the Document by its id.
+    ///
+    /// Ids are kept in a hash index that is updated as Elements are added,
+    /// removed or renamed, so the lookup does not search the tree. If several
+    /// Elements share the id, the first in tree order is returned.
+    ///
+    /// \param id The id to find.
+    /// \returns the matching Element or nullptr if none exists.
+    Element* getElementById(const std::string& id);
+
+    /// \brief Find all Elements in the Document with an id.
+    /// \param id The id to find.
+    /// \returns the matching Elements in tree order.
+    std::vector<Element*> getElementsById(const std::string& id);
+
+    /// \brief Register a type tag for use in selectors.
+    ///
+    /// Elements of ElementType, including derived types, match the tag in
+    /// Element::querySelector(). Each Element is tested once when it is added
+    /// to the Document, so queries do not cast Elements. Unregistered tags
+    /// match nothing.
+    ///
+    /// \param tag The type tag, made of letters, digits, '-' and '_'.
+    /// \tparam ElementType The Element type to tag.
+    template <typename ElementType>
+    void registerTypeTag(const std::string& tag);
+
+    /// \brief The maximum number of compiled selectors kept in the cache.
+    static const std::size_t MAX_CACHED_SELECTORS;
+
+    /// \brief Enable or disable the GeometryStore for this Document.
+    ///
+    /// When enabled, the shapes and flags of all Elements in the Document are
+    /// packed into a GeometryStore, which is used for pointer hit tests that
+    /// search the whole tree. Elements that override Element::hitTest() or
+    /// Element::childHitTest() are tested as rectangles.
+    ///
+    /// \param enabled True if the GeometryStore should be used.
+    void setGeometryStoreEnabled(bool enabled);
+
+    /// \returns true if the GeometryStore is enabled.
+    bool isGeometryStoreEnabled() const;
+
+    /// \returns the GeometryStore or nullptr if it is not enabled.
+    GeometryStore* geometryStore();
+
+    /// \brief Determine if pointermove events should be coalesced.
+    ///
+    /// When enabled, consecutive pointermove events for each pointer id are
+    /// held until the next update or the next non-move event for that pointer
+    /// and then dispatched as a single event. The raw samples are available
+    /// from PointerUIEventArgs::coalescedEvents(). This bounds the dispatch
+    /// rate by the frame rate rather than the device rate.
+    ///
+    /// Disabling coalescing dispatches any pending pointermove events.
+    ///
+    /// \param pointerMoveCoalescing True if pointermove events should be coalesced.
+    void setPointerMoveCoalescing(bool pointerMoveCoalescing);
+
+    /// \returns true if pointermove events are coalesced.
+    bool getPointerMoveCoalescing() const;
+
+    /// \brief Set the number of predicted positions for coalesced pointermove events.
+    ///
+    /// The positions are linearly extrapolated from the last two samples and
+    /// are available from PointerUIEventArgs::predictedPositions(). This is
+    /// only used when pointermove coalescing is enabled.
+    ///
+    /// \param count The number of predicted positions, or 0 to disable.
+    void setPointerMovePredictionCount(std::size_t count);
+
+    /// \returns the number of predicted positions for coalesced pointermove events.
+    std::size_t getPointerMovePredictionCount() const;
+
+    /// \brief Dispatch all pending coalesced pointermove events.
+    ///
+    /// This is called automatically during update.
+    ///
+    /// \returns the number of events that were handled.
+    std::size_t flushPointerMoves();
+
+    /// \brief Determine if input events should be queued until the next update.
+    ///
+    /// When enabled, onPointerEvent() and onKeyEvent() only add the event to
+    /// a preallocated queue. The queued events are dispatched in order by
+    /// flushEvents(), which is called at the beginning of each update. This
+    /// keeps input handling from interleaving with the rest of the app and
+    /// allows the whole input phase to be coalesced and profiled as one unit.
+    ///
+    /// Disabling queueing dispatches any queued events.
+    ///
+    /// \param eventQueueing True if input events should be queued.
+    void setEventQueueing(bool eventQueueing);
+
+    /// \returns true if input events are queued until the next update.
+    bool getEventQueueing() const;
+
+    /// \brief Dispatch all queued input events.
+    ///
+    /// Events queued while flushing are dispatched on the next flush. This is
+    /// called automatically during update.
+    ///
+    /// \returns the number of events that were handled.
+    std::size_t flushEvents();
+
+    /// \brief Inject a pointer event from any thread.
+    ///
+    /// The event is added to a lock-free queue and passed to onPointerEvent()
+    /// on the main thread during the next update. The caller never blocks on
+    /// the Document or on other injecting threads.
+    ///
+    /// \param e The PointerEventArgs to inject.
+    void injectPointerEvent(const PointerEventArgs& e);
+
+    /// \brief Inject a key event from any thread.
+    ///
+    /// The event is added to a lock-free queue and passed to onKeyEvent() on
+    /// the main thread during the next update.
+    ///
+    /// \param e The key event to inject.
+    void injectKeyEvent(const ofKeyEventArgs& e);
+
+    /// \brief Handle all injected events.
+    ///
+    /// This must be called on the main thread and is called automatically
+    /// during update.
+    ///
+    /// \returns the number of events that were handled.
+    std::size_t flushInjectedEvents();
+
+    /// \brief Set the recorder for input events reaching the Document.
+    ///
+    /// Every event passed to onPointerEvent(), onPointerEvents() or
+    /// onKeyEvent() is recorded before it is queued, coalesced or dispatched. The recording can be
+    /// replayed with InputReplay.
+    ///
+    /// \param recorder The recorder, or nullptr to stop recording. The
+    /// recorder must remain valid until it is removed.
+    void setInputRecorder(InputRecorder* recorder);
+
+    /// \returns the input recorder or nullptr if none.
+    InputRecorder* getInputRecorder() const;
+
+    /// \brief Deliver the pending MutationRecords to their observers.
+    ///
+    /// Each observer with pending records receives them in a single call.
+    /// Records queued by the callbacks are delivered by the next call. This
+    /// must be called on the main thread and is called automatically during
+    /// update.
+    ///
+    /// \returns the number of records that were delivered.
+    std::size_t deliverMutationRecords();
+
     /// \brief Callback for pointer events.
+    ///
+    /// If event queueing is enabled, the event is queued and false is returned.
+    ///
     /// \param e The PointerEventArgs.
     /// \returns true if the event was handled.
     /// \todo Implement way to call default action if the event is not handled.
     bool onPointerEvent(PointerEventArgs& e);
 
+    /// \brief Callback for a batch of pointer events, e.g. from a single frame.
+    ///
+    /// The targets for all events are found in a single traversal of the
+    /// Document tree, then the events are dispatched in their original order.
+    /// Targets are found using the state of the tree before any of the events
+    /// are dispatched.
+    ///
+    /// \param events The PointerEventArgs to dispatch.
+    /// \returns the number of events that were handled.
+    std::size_t onPointerEvents(std::vector<PointerEventArgs>& events);
+
     /// \brief Set a pointer capture on a given Element.
     /// \param element A pointer to the capturing Element.
     /// \param id The pointer id to capture.
@@ -87,11 +279,26 @@ public:
 
 protected:
     /// \brief Map pointer ids to Elements.
-    typedef std::unordered_map<std::size_t, Element*> PointerElementMap;
+    typedef PointerMap<Element*> PointerElementMap;
 
     /// \brief True if the Document size should always match the screen size.
     bool _autoFillScreen = true;
 
+    /// \brief True if pointer hit tests are seeded by the last active target.
+    bool _incrementalHitTesting = false;
+
+    /// \brief True if pointermove events are coalesced.
+    bool _pointerMoveCoalescing = false;
+
+    /// \brief The number of predicted positions for coalesced pointermove events.
+    std::size_t _pointerMovePredictionCount = 0;
+
+    /// \brief True if input events are queued until the next update.
+    bool _eventQueueing = false;
+
+    /// \brief The recorder for input events or nullptr if none.
+    InputRecorder* _inputRecorder = nullptr;
+
     /// \brief Captured pointer and their capture target.
     PointerElementMap _capturedPointerIdToElementMap;
 
@@ -119,19 +326,205 @@ protected:
     /// hovering (e.g. multi-touch surfaces) the pointer ids will only be
     /// recorded until they leave the surface via a pointerup or pointercancel
     /// event.
-    std::unordered_map<std::size_t, PointerEventArgs> _activePointers;
+    PointerMap<PointerEventArgs> _activePointers;
 
     /// \brief The Element that currently has focus.
     Element* _focusedElement = nullptr;
 
 private:
+    /// \brief Start queueing records for an observer.
+    /// \param observer The observer to add.
+    void addMutationObserver(MutationObserver* observer);
+
+    /// \brief Stop queueing records for an observer.
+    /// \param observer The observer to remove.
+    void removeMutationObserver(MutationObserver* observer);
+
+    /// \returns true if any MutationObserver is observing this Document.
+    bool hasMutationObservers() const;
+
+    /// \brief Queue a record for each observer that matches it.
+    /// \param record The record to queue.
+    void queueMutationRecord(const MutationRecord& record);
+
+    /// \brief Forget a subtree that is leaving this Document.
+    ///
+    /// Pending records targeting the subtree are discarded and observers stop
+    /// observing its Elements, so neither refers to an Element that may be
+    /// destroyed before the records are delivered.
+    ///
+    /// \param subtree The root of the subtree.
+    void removeMutationTargets(Element* subtree);
+
+    /// \brief Forget pointer and focus state held by a leaving subtree.
+    ///
+    /// Active targets and pointer captures in the subtree are dropped and
+    /// the focused Element is cleared if it is in the subtree, so later
+    /// pointer and keyboard events never reach a destroyed Element.
+    ///
+    /// \param subtree The root of the subtree.
+    void removePointerTargets(Element* subtree);
+
+    /// \param element The Element to test, may be nullptr.
+    /// \param subtree The root of the subtree.
+    /// \returns true if the element is the subtree root or a descendant of it.
+    static bool isInSubtree(const Element* element, const Element* subtree);
+
     /// \brief Utility method to find an Element mapped to a pointer id.
     /// \param id The pointer id to search for.
     /// \param pem The pointer element map to search.
     /// \returns the matching element or nullptr if no match is found.
     static Element* findElementInMap(std::size_t id, PointerElementMap& pem);
 
+    /// \brief Handle a pointer event without queueing it.
+    /// \param e The PointerEventArgs.
+    /// \returns true if the event was handled.
+    bool handlePointerEvent(PointerEventArgs& e);
+
+    /// \brief Handle a key event without queueing it.
+    /// \param e The key event.
+    /// \returns true if the event was handled.
+    bool handleKeyEvent(ofKeyEventArgs& e);
+
+    /// \brief Add an Element and its descendants to the indexes.
+    /// \param subtree The root of the subtree.
+    void addToIndexes(Element* subtree);
+
+    /// \brief Remove an Element and its descendants from the indexes.
+    /// \param subtree The root of the subtree.
+    void removeFromIndexes(Element* subtree);
+
+    /// \brief Add a single Element to the index.
+    /// \param id The Element's id.
+    /// \param element The Element.
+    void addToIdIndex(const std::string& id, Element* element);
+
+    /// \brief Remove a single Element from the index.
+    /// \param id The Element's id.
+    /// \param element The Element.
+    void removeFromIdIndex(const std::string& id, Element* element);
+
+    /// \brief Add a single Element to the index for an attribute.
+    /// \param name The attribute name.
+    /// \param element The Element.
+    void addToAttributeIndex(const std::string& name, Element* element);
+
+    /// \brief Remove a single Element from the index for an attribute.
+    /// \param name The attribute name.
+    /// \param element The Element.
+    void removeFromAttributeIndex(const std::string& name, Element* element);
+
+    /// \brief Register the test for a type tag and index the tree with it.
+    /// \param tag The type tag.
+    /// \param test Returns true for Elements of the tagged type.
+    void registerTypeTag(const std::string& tag,
+                         std::function<bool(const Element*)> test);
+
+    /// \brief Find the descendants of an Element matching a selector.
+    /// \param selectors The Selector text.
+    /// \param scope The Element whose descendants are searched.
+    /// \param firstOnly True if only the first match is needed.
+    /// \param results The vector to receive the matches in tree order.
+    /// \throws DOMException if the selector is not valid.
+    void query(const std::string& selectors,
+               Element* scope,
+               bool firstOnly,
+               std::vector<Element*>& results);
+
+    /// \brief Find the candidates for the subject of a selector.
+    /// \param compound The subject Compound.
+    /// \param scope The Element whose descendants are searched.
+    /// \param candidates The vector to receive the candidates.
+    /// \returns true if the candidates are in tree order.
+    bool findCandidates(const Selector::Compound& compound,
+                        Element* scope,
+                        std::vector<Element*>& candidates);
+
+    /// \brief Determine if an Element matches a Compound.
+    /// \param element The Element to test.
+    /// \param compound The Compound to test.
+    /// \returns true iff all tests in the Compound pass.
+    bool matches(Element* element, const Selector::Compound& compound) const;
+
+    /// \brief Determine if an Element's ancestors match the rest of a Complex.
+    /// \param element An Element matching the Compound at index.
+    /// \param complex The Complex to test.
+    /// \param index The index of the Compound matched by element.
+    /// \returns true iff the Compounds before index match.
+    bool matchesAncestors(Element* element,
+                          const Selector::Complex& complex,
+                          std::size_t index) const;
+
+    /// \brief Determine if one Element precedes another in tree order.
+    /// \param a The first Element.
+    /// \param b The second Element, in the same tree as the first.
+    /// \returns true iff a is an ancestor of b or is in front of it.
+    static bool precedes(const Element* a, const Element* b);
+
+    /// \brief Search the whole tree for the Element at a position.
+    /// \param screenPosition The position to test in screen coordinates.
+    /// \returns A pointer to the target Element or a nullptr if none found.
+    Element* fullHitTest(const Position& screenPosition);
+
+    /// \brief Find the Element hit by a pointer event.
+    /// \param e The PointerEventArgs.
+    /// \returns A pointer to the target Element or a nullptr if none found.
+    Element* findPointerTarget(const PointerEventArgs& e);
+
+    /// \brief Dispatch a pointer event to a known active target.
+    /// \param e The PointerEventArgs.
+    /// \param activeTarget The Element hit by the pointer or nullptr if none.
+    /// \param coalescedEvents The coalesced samples or nullptr if none.
+    /// \param predictedPositions The predicted positions or nullptr if none.
+    /// \returns true if the event was handled.
+    bool dispatchPointerEvent(PointerEventArgs& e,
+                              Element* activeTarget,
+                              const std::vector<PointerEventArgs>* coalescedEvents = nullptr,
+                              const std::vector<Position>* predictedPositions = nullptr);
+
+    /// \brief Dispatch the pending coalesced pointermove event for a pointer.
+    /// \param id The pointer id.
+    /// \returns true if the event was handled.
+    bool flushPointerMoves(std::size_t id);
+
+    /// \brief Find the target Element for a position starting with a seed.
+    ///
+    /// The seed and its ancestors are searched until a target is found in
+    /// a subtree that is not occluded by any Element in front of it. If none
+    /// is found, a full search is done.
+    ///
+    /// \param seed The Element to start searching from, usually the last
+    ///        target. It must be in this Document.
+    /// \param screenPosition The position to test in screen coordinates.
+    /// \returns A pointer to the target Element or a nullptr if none found.
+    Element* seededHitTest(Element* seed, const Position& screenPosition);
+
+    /// \brief Determine if an Element's subtree may be hit at a position.
+    ///
+    /// An Element's subtree is exposed if it and all of its ancestors are
+    /// enabled, visible and accept child hit tests at the position, and no
+    /// Element in front of it or its ancestors has a total shape containing
+    /// the position.
+    ///
+    /// \param element The Element to test.
+    /// \param screenPosition The position to test in screen coordinates.
+    /// \returns true iff the Element's subtree is exposed at the position.
+    bool isExposed(Element* element, const Position& screenPosition);
+
+    /// \brief Find the lowest common ancestor of two Elements.
+    /// \param a The first Element, or nullptr.
+    /// \param b The second Element, or nullptr.
+    /// \returns the deepest Element that is, or is an ancestor of, both
+    /// Elements, or nullptr if there is none.
+    static Element* findCommonAncestor(Element* a, Element* b);
+
     /// \brief Synthesize pointerout and pointerleave events on the target.
+    ///
+    /// The pointerleave event is sent to the target and each of its
+    /// ancestors below the common ancestor of the target and related target.
+    /// Each pointerleave is dispatched through the capture phase of the
+    /// receiving Element's ancestors and does not bubble.
+    ///
     /// \param e The PointerEventArgs that caused the events.
     /// \param target The target to receive the events.
     /// \param relatedTarget The target that this is transitioning from.
@@ -140,6 +533,12 @@ private:
                                       Element* relatedTarget);
 
     /// \brief Synthesize pointerover and pointerenter events on the target.
+    ///
+    /// The pointerenter event is sent to each ancestor of the target below
+    /// the common ancestor of the target and related target, then to the
+    /// target. Each pointerenter is dispatched through the capture phase of
+    /// the receiving Element's ancestors and does not bubble.
+    ///
     /// \param e The PointerEventArgs that caused the events.
     /// \param target The target to receive the events.
     /// \param relatedTarget The target that this is transitioning from.
@@ -148,6 +547,63 @@ private:
                                        Element* relatedTarget);
 
 
+    /// \brief Batch hit test positions, reused between batches.
+    std::vector<Position> _batchPositions;
+
+    /// \brief Batch hit test indices, reused between batches.
+    std::vector<std::size_t> _batchIndices;
+
+    /// \brief Batch hit test targets, reused between batches.
+    std::vector<Element*> _batchTargets;
+
+    /// \brief Batch hit test buffers for each tree depth, reused between batches.
+    std::deque<HitTestScratch> _batchScratch;
+
+    /// \brief Pending pointermove samples for each pointer id.
+    std::unordered_map<std::size_t, std::vector<PointerEventArgs>> _coalescedPointerMoves;
+
+    /// \brief Pointer ids with pending pointermove samples, in arrival order.
+    std::vector<std::size_t> _coalescedPointerIds;
+
+    /// \brief Predicted positions, reused between events.
+    std::vector<Position> _predictedPositions;
+
+    /// \brief Input events waiting for the next flush.
+    EventQueue _eventQueue;
+
+    /// \brief Input events being dispatched by the current flush.
+    ///
+    /// The queues are swapped when flushing, so events queued by listeners
+    /// never move the events being dispatched.
+    EventQueue _flushingEventQueue;
+
+    /// \brief Input events injected from other threads.
+    ConcurrentEventQueue _injectedEvents;
+
+    /// \brief The injected event being handled, reused between events.
+    EventQueue::Entry _injectedEvent;
+
+    /// \brief The Elements with each non-empty id.
+    std::unordered_map<std::string, std::vector<Element*>> _elementsById;
+
+    /// \brief The Elements with each attribute.
+    std::unordered_map<std::string, std::unordered_set<Element*>> _elementsByAttribute;
+
+    /// \brief The Elements with each registered type tag.
+    std::unordered_map<std::string, std::unordered_set<Element*>> _elementsByTypeTag;
+
+    /// \brief The registered type tags and their tests.
+    std::vector<std::pair<std::string, std::function<bool(const Element*)>>> _typeTags;
+
+    /// \brief Compiled selectors by their text.
+    std::unordered_map<std::string, Selector> _selectors;
+
+    /// \brief The GeometryStore for this Document or nullptr if disabled.
+    std::unique_ptr<GeometryStore> _ownedGeometryStore;
+
+    /// \brief The observers of Elements in this Document.
+    std::vector<MutationObserver*> _mutationObservers;
+
     /// \brief Setup event listener.
     ofEventListener _setupListener;
 
@@ -177,7 +633,25 @@ private:
 
     /// \brief The event source window.
     ofAppBaseWindow* _window = nullptr;
+
+    /// \brief The Element class queues MutationRecords.
+    friend class Element;
+
+    /// \brief The MutationObserver class adds and removes itself.
+    friend class MutationObserver;
+
 };
 
 
+template <typename ElementType>
+void Document::registerTypeTag(const std::string& tag)
+{
+    static_assert(std::is_base_of<Element, ElementType>(), "ElementType must be an Element or derived from Element.");
+
+    registerTypeTag(tag, [](const Element* element) {
+        return dynamic_cast<const ElementType*>(element) != nullptr;
+    });
+}
+
+
 } } // namespace ofx::DOM
@@ -8,13 +8,18 @@
 #pragma once
 
 
+#include <deque>
 #include <unordered_set>
 #include "ofx/PointerEvents.h"
+#include "ofx/DOM/AttributeStore.h"
 #include "ofx/DOM/CapturedPointer.h"
 #include "ofx/DOM/Events.h"
 #include "ofx/DOM/EventTarget.h"
 #include "ofx/DOM/Exceptions.h"
+#include "ofx/DOM/GeometryStore.h"
 #include "ofx/DOM/Layout.h"
+#include "ofx/DOM/MutationObserver.h"
+#include "ofx/DOM/SpatialIndex.h"
 #include "ofx/DOM/Types.h"
 
 
@@ -93,6 +98,23 @@ public:
     template <typename ElementType, typename... Args>
     ElementType* addChild(Args&&... args);
 
+    /// \brief Take ownership of several child Elements at once.
+    ///
+    /// This is equivalent to calling addChild() for each Element, but the
+    /// child shape is invalidated and the layout is done only once.
+    ///
+    /// Instead of a childAdded and siblingAdded event for each Element, a
+    /// single childrenAdded event is sent to this Element and a single
+    /// siblingsAdded event is sent to each of its children. The siblingsAdded
+    /// event includes all added Elements, which may include the receiver.
+    /// Each added Element still receives an addedTo event.
+    ///
+    /// \param elements The Elements to add. Null pointers are ignored.
+    /// \returns pointers to the added Elements, in order.
+    /// \tparam ElementType The subclass of Element that will be added.
+    template <typename ElementType>
+    std::vector<ElementType*> addChildren(std::vector<std::unique_ptr<ElementType>> elements);
+
     /// \brief Release ownership of a child Element.
     /// \param element The Element to release.
     /// \returns a std::unique_ptr<Element> to the child.
@@ -205,6 +227,27 @@ public:
     /// \returns a vector of pointers to child elements or an empty vector if none exist.
     std::vector<Element*> findChildrenById(const std::string& id);
 
+    /// \brief Find the first descendant matching a selector.
+    ///
+    /// Candidates are taken from the Document's id, attribute and type tag
+    /// indexes, so the tree is only walked for selectors with none of these.
+    /// Compiled selectors are cached by the Document.
+    ///
+    /// \param selectors The Selector text.
+    /// \returns the first matching descendant in tree order or nullptr.
+    /// \throws DOMException if the selector is not valid or this Element is
+    /// not in a Document.
+    /// \sa Selector
+    Element* querySelector(const std::string& selectors);
+
+    /// \brief Find all descendants matching a selector.
+    /// \param selectors The Selector text.
+    /// \returns the matching descendants in tree order.
+    /// \throws DOMException if the selector is not valid or this Element is
+    /// not in a Document.
+    /// \sa Selector
+    std::vector<Element*> querySelectorAll(const std::string& selectors);
+
     /// \brief Get a pointer to the parent.
     /// \returns a pointer to the parent or a nullptr.
     Element* parent();
@@ -262,7 +305,8 @@ public:
     ///
     /// For a normal Element, the hit test will test the rectangular shape
     /// of the Element. Subclasses can override this method for custom hit test
-    /// geometry.
+    /// geometry within that shape. Positions outside the Element's total shape
+    /// are rejected by its parent without calling this method.
     ///
     /// Parent coordinates are used because the shape / position of the
     /// Element are in parent coordinates.
@@ -276,6 +320,19 @@ public:
     /// \returns true iff the local position is within the hit test region.
     virtual bool childHitTest(const Position& localPosition) const;
 
+    /// \brief Enable or disable the spatial index for the child Elements.
+    ///
+    /// When enabled, hit tests use a SpatialIndex to find the child Elements
+    /// under a position rather than testing each child in turn. This is useful
+    /// for Elements with many children. The index assumes that the hit test
+    /// region of each child lies within the child's total shape.
+    ///
+    /// \param enabled True to enable the spatial index.
+    void setSpatialIndexEnabled(bool enabled);
+
+    /// \returns true iff the spatial index is enabled for the child Elements.
+    bool isSpatialIndexEnabled() const;
+
     /// \brief Convert the local coordinates to screen coordinates.
     ///
     /// Local coordinates are defined with reference to the position of the box.
@@ -330,8 +387,11 @@ public:
     float getY() const;
 
     /// \brief Get the Position of the Element in screen coordinates.
+    ///
+    /// The screen position is cached and only recalculated after this Element
+    /// or one of its ancestors is moved or reparented.
+    ///
     /// \returns the Position of the Element in screen coordinates.
-    /// \todo Cache screen position w/ shape.
     Position getScreenPosition() const;
 
     /// \brief Get the X position of the Element in screen coordinates.
@@ -381,9 +441,12 @@ public:
     /// The id is optional and an empty std::string by default.
     ///
     /// \returns the id of the Element.
-    std::string getId() const;
+    const std::string& getId() const;
 
     /// \brief Set the id of the Element.
+    ///
+    /// If the Element is in a Document, the Document's id index is updated.
+    ///
     /// \param id The new id of the Element.
     void setId(const std::string& id);
 
@@ -418,6 +481,9 @@ public:
     /// \param The name of the attribute to clear.
     void clearAttribute(const std::string& name);
 
+    /// \returns the attributes of this Element.
+    const AttributeStore& attributes() const;
+
     /// \brief Request that the parent Document capture the given pointer id.
     ///
     /// Captured pointers send all of their revents to the capturing Element.
@@ -486,13 +552,60 @@ protected:
     /// \param e The event data.
     void _exit(ofEventArgs& e);
 
+    /// \brief The buffers used by one level of a batched recursiveHitTest().
+    struct HitTestScratch
+    {
+        /// \brief A position waiting to be tested against a child.
+        struct Pending
+        {
+            std::size_t index;
+            std::size_t cursor;
+            std::size_t child;
+        };
+
+        /// \brief The positions that may hit a child.
+        std::vector<Pending> pending;
+
+        /// \brief The positions assigned to their next candidate child.
+        std::vector<Pending> assigned;
+
+        /// \brief The position indices passed to a single child.
+        std::vector<std::size_t> subset;
+    };
+
     /// \brief A recursive hit test to find a target element.
     /// \param parentPosition The parent coordinates to test.
     /// \returns A pointer to the target Element or a nullptr if none found.
     /// \todo Provide a seed position to speed up search?
     Element* recursiveHitTest(const Position& parentPosition);
 
+    /// \brief A recursive hit test to find target elements for many positions.
+    ///
+    /// The tree is traversed once. The positions are partitioned by the total
+    /// shapes of the child Elements, so each subtree is only searched for the
+    /// positions that may hit it. The result is the same as a call to
+    /// recursiveHitTest() for each position as long as the hit test region of
+    /// each Element lies within its total shape.
+    ///
+    /// \param screenPositions The positions to test in screen coordinates.
+    /// \param parentScreenPosition The screen position of the parent's origin.
+    /// \param indices The indices of the positions to test. On return, it
+    /// contains the indices of the positions that did not hit this subtree.
+    /// \param targets The target Element for each position. Targets are set
+    /// for each index that hits this subtree.
+    /// \param scratch Buffers reused between batches, one per tree depth.
+    /// \param depth The depth of this Element in the traversal.
+    void recursiveHitTest(const std::vector<Position>& screenPositions,
+                          const Position& parentScreenPosition,
+                          std::vector<std::size_t>& indices,
+                          std::vector<Element*>& targets,
+                          std::deque<HitTestScratch>& scratch,
+                          std::size_t depth = 0);
+
     /// \brief Find a child by a raw Element pointer.
+    ///
+    /// This is a constant time lookup using the child's stored index.
+    ///
     /// \param The pointer to the child.
     /// \returns An iterator pointing to the matching Element or the end.
     std::vector<std::unique_ptr<Element>>::iterator findChild(Element* element);
@@ -542,11 +655,79 @@ private:
     /// \brief Non copyable.
     Element& operator = (const Element&) = delete;
 
+    /// \brief Invalidate the cached screen position of this Element's subtree.
+    void _invalidateScreenPosition();
+
+    /// \brief Move a child to a new index, shifting the children between.
+    ///
+    /// The SpatialIndex and GeometryStore are updated in place.
+    /// \param oldIndex The child's current index.
+    /// \param newIndex The child's new index.
+    void _moveChild(std::size_t oldIndex, std::size_t newIndex);
+
+    /// \brief Store the index of each child in a range.
+    /// \param first The first child index to update.
+    /// \param last The index to stop at, exclusive.
+    void _reindexChildren(std::size_t first, std::size_t last);
+
+    /// \brief Add a subtree to this Element's Document indexes.
+    /// \param subtree The root of the subtree.
+    void _addToIndexes(Element* subtree);
+
+    /// \brief Add several subtrees to this Element's Document indexes.
+    /// \param subtrees The roots of the subtrees.
+    void _addToIndexes(const std::vector<Element*>& subtrees);
+
+    /// \brief Remove a subtree from this Element's Document indexes.
+    ///
+    /// The Document also drops any pointer targets, captures and focus held
+    /// by the subtree.
+    ///
+    /// \param subtree The root of the subtree.
+    void _removeFromIndexes(Element* subtree);
+
+    /// \brief Add this Element to its Document's index for an attribute.
+    /// \param name The attribute name.
+    void _addToAttributeIndex(const std::string& name);
+
+    /// \brief Remove this Element from its Document's index for an attribute.
+    /// \param name The attribute name.
+    void _removeFromAttributeIndex(const std::string& name);
+
+    /// \brief Remove this Element's subtree from its GeometryStore.
+    void _detachGeometryStore();
+
+    /// \brief Get the Document that queues MutationRecords for this Element.
+    /// \returns the Document, or nullptr if the Element is not in a Document
+    /// or the Document has no MutationObservers.
+    Document* _mutationDocument();
+
+    /// \brief Queue a MutationRecord for a single added or removed child.
+    /// \param addedElement The added child or nullptr if none.
+    /// \param removedElement The removed child or nullptr if none.
+    void _queueChildListMutation(Element* addedElement, Element* removedElement);
+
+    /// \brief Queue a MutationRecord for several added children.
+    /// \param addedElements The added children.
+    void _queueChildListMutation(const std::vector<Element*>& addedElements);
+
+    /// \brief Queue a MutationRecord for a reordered child.
+    /// \param element The reordered child.
+    /// \param oldIndex The old child index.
+    /// \param newIndex The new child index.
+    void _queueChildOrderMutation(Element* element,
+                                  std::size_t oldIndex,
+                                  std::size_t newIndex);
+
+    /// \brief Queue a MutationRecord for a set or cleared attribute.
+    /// \param name The attribute name.
+    void _queueAttributeMutation(const std::string& name);
+
     /// \brief A callback for child Elements to notify their parent of movement.
-    void _onChildMoved(MoveEventArgs&);
+    void _onChildMoved(const void* sender, MoveEventArgs&);
 
     /// \brief A callback for child Elements to notify their parent size changes.
-    void _onChildResized(ResizeEventArgs&);
+    void _onChildResized(const void* sender, ResizeEventArgs&);
 
     /// \brief The id for this element.
     std::string _id;
@@ -557,11 +738,26 @@ private:
     /// \brief The union of all child bounding boxes.
     mutable Shape _childShape;
 
+    /// \brief The total shapes of the children, valid with the child shape.
+    ///
+    /// The left, top, right and bottom edges are packed as four consecutive
+    /// arrays of numChildren() floats, as ShapeKernels expects.
+    mutable std::vector<float> _childEdges;
+
     /// \brief True if the child shape is invalid.
     ///
     /// This variable usually set by callbacks from the child elements.
     mutable bool _childShapeInvalid = true;
 
+    /// \brief The cached position of this Element in screen coordinates.
+    mutable Position _screenPosition;
+
+    /// \brief True if the cached screen position is invalid.
+    ///
+    /// If an Element's screen position is invalid, the screen positions of
+    /// all of its descendants are also invalid.
+    mutable bool _screenPositionInvalid = true;
+
     /// \brief The enabled state of this Element.
     bool _enabled = true;
 
@@ -581,8 +777,7 @@ private:
     // int _tabIndex = 0;
 
     /// \brief A collection of named attributes.
-    /// \todo This may not be permanent.
-    std::unordered_map<std::string, Any> _attributes;
+    AttributeStore _attributes;
 
     /// \brief Automatically capture the pointer on pointer down.
     bool _implicitPointerCapture = false;
@@ -595,15 +790,33 @@ private:
     /// \brief The Layout associated with this
     std::unique_ptr<Layout> _layout = nullptr;
 
+    /// \brief An optional spatial index for the child Elements.
+    std::unique_ptr<SpatialIndex> _spatialIndex = nullptr;
+
+    /// \brief The GeometryStore holding this Element or nullptr if none.
+    GeometryStore* _geometryStore = nullptr;
+
+    /// \brief The slot of this Element in its GeometryStore.
+    std::size_t _geometrySlot = 0;
+
     /// \brief An optional pointer to a parent Node.
     Element* _parent = nullptr;
 
+    /// \brief The index of this Element in its parent's children.
+    std::size_t _childIndex = 0;
+
     /// \brief A vector to Elements.
     std::vector<std::unique_ptr<Element>> _children;
 
     /// \brief The Layout class has access to all private variables.
     friend class Layout;
 
+    /// \brief The SpatialIndex class has access to all private variables.
+    friend class SpatialIndex;
+
+    /// \brief The GeometryStore class has access to all private variables.
+    friend class GeometryStore;
+
     /// \brief The Document class has access to all private variables.
     friend class Document;
 
@@ -630,19 +843,42 @@ ElementType* Element::addChild(std::unique_ptr<ElementType> element)
         // Assign the parent to the node via the raw pointer.
         pNode->_parent = this;
 
+        // Include the node's listeners when dispatching through this Element.
+        updateSubtreeListenerCounts(*pNode, true);
+
+        // The node's screen position is now relative to this Element.
+        pNode->_invalidateScreenPosition();
+
         // Take ownership of the node.
+        pNode->_childIndex = _children.size();
         _children.push_back(std::move(element));
 
         // Invalidate all cached child shape.
         invalidateChildShape();
 
+        // The child indices have changed.
+        if (_spatialIndex)
+        {
+            _spatialIndex->invalidate();
+        }
+
+        if (_geometryStore)
+        {
+            _geometryStore->invalidate();
+        }
+
         // Alert the node that its parent was set.
         ElementEventArgs addedEvent(this);
         ofNotifyEvent(pNode->addedTo, addedEvent, this);
 
+        // Make the node's subtree findable by id, attribute and type.
+        _addToIndexes(pNode);
+
         ElementEventArgs childAddedEvent(pNode);
         ofNotifyEvent(childAdded, childAddedEvent, this);
 
+        _queueChildListMutation(pNode, nullptr);
+
         // Attach child listeners.
         ofAddListener(pNode->move, this, &Element::_onChildMoved);
         ofAddListener(pNode->resize, this, &Element::_onChildResized);
@@ -665,6 +901,90 @@ ElementType* Element::addChild(std::unique_ptr<ElementType> element)
 }
 
 
+template <typename ElementType>
+std::vector<ElementType*> Element::addChildren(std::vector<std::unique_ptr<ElementType>> elements)
+{
+    static_assert(std::is_base_of<Element, ElementType>(), "ElementType must be an Element or derived from Element.");
+
+    std::vector<ElementType*> addedNodes;
+    addedNodes.reserve(elements.size());
+
+    _children.reserve(_children.size() + elements.size());
+
+    for (auto& element : elements)
+    {
+        if (element)
+        {
+            // Get a raw pointer to the node for later.
+            ElementType* pNode = element.get();
+
+            // Assign the parent to the node via the raw pointer.
+            pNode->_parent = this;
+
+            // Include the node's listeners when dispatching through this Element.
+            updateSubtreeListenerCounts(*pNode, true);
+
+            // The node's screen position is now relative to this Element.
+            pNode->_invalidateScreenPosition();
+
+            // Take ownership of the node.
+            pNode->_childIndex = _children.size();
+            _children.push_back(std::move(element));
+
+            addedNodes.push_back(pNode);
+        }
+    }
+
+    if (addedNodes.empty())
+    {
+        return addedNodes;
+    }
+
+    // Invalidate all cached child shape once for all nodes.
+    invalidateChildShape();
+
+    // The child indices have changed.
+    if (_spatialIndex)
+    {
+        _spatialIndex->invalidate();
+    }
+
+    if (_geometryStore)
+    {
+        _geometryStore->invalidate();
+    }
+
+    ElementEventArgs addedEvent(this);
+
+    for (ElementType* pNode : addedNodes)
+    {
+        // Alert the node that its parent was set.
+        ofNotifyEvent(pNode->addedTo, addedEvent, this);
+
+        // Attach child listeners.
+        ofAddListener(pNode->move, this, &Element::_onChildMoved);
+        ofAddListener(pNode->resize, this, &Element::_onChildResized);
+    }
+
+    ElementListEventArgs childrenAddedEvent(std::vector<Element*>(addedNodes.begin(), addedNodes.end()));
+
+    // Make the nodes' subtrees findable by id, attribute and type.
+    _addToIndexes(childrenAddedEvent.elements());
+
+    ofNotifyEvent(childrenAdded, childrenAddedEvent, this);
+
+    _queueChildListMutation(childrenAddedEvent.elements());
+
+    /// Alert the nodes that they have new siblings.
+    for (auto& child : _children)
+    {
+        ofNotifyEvent(child->siblingsAdded, childrenAddedEvent, this);
+    }
+
+    return addedNodes;
+}
+
+
 template <typename ElementType>
 std::vector<ElementType*> Element::siblings()
 {
@@ -744,11 +1064,11 @@ LayoutType* Element::setLayout(std::unique_ptr<LayoutType> layout)
 template <typename AnyType>
 AnyType Element::getAttribute(const std::string& key, bool inherit) const
 {
-    auto iter = _attributes.find(key);
+    const Any* value = _attributes.find(key);
 
-    if (iter != _attributes.end() && iter->second.is<AnyType>())
+    if (value != nullptr && value->is<AnyType>())
     {
-        return iter->second.as<AnyType>();
+        return value->as<AnyType>();
     }
     else if (inherit && hasParent())
     {
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <vector>
+#include "ofEvents.h"
+#include "ofx/PointerEvents.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief A ring buffer of input events waiting to be dispatched.
+///
+/// Entries are stored by value in preallocated storage, so pushing and
+/// popping does not allocate unless the queue must grow past its capacity.
+///
+/// Generally this class should not be instantiated directly but instead
+/// should be enabled using Document::setEventQueueing(true).
+class EventQueue
+{
+public:
+    /// \brief A single queued input event.
+    struct Entry
+    {
+        /// \brief The kind of input event.
+        enum class Type
+        {
+            /// \brief The entry holds a PointerEventArgs.
+            POINTER,
+            /// \brief The entry holds an ofKeyEventArgs.
+            KEY
+        };
+
+        /// \brief The kind of input event.
+        Type type = Type::POINTER;
+
+        /// \brief The pointer event, valid if type is Type::POINTER.
+        PointerEventArgs pointer;
+
+        /// \brief The key event, valid if type is Type::KEY.
+        ofKeyEventArgs key;
+    };
+
+    /// \brief Create an empty EventQueue with no storage.
+    EventQueue();
+
+    /// \brief Destroy the EventQueue.
+    ~EventQueue();
+
+    /// \brief Move the storage and entries of another EventQueue.
+    EventQueue(EventQueue&& other) noexcept = default;
+
+    /// \brief Move the storage and entries of another EventQueue.
+    EventQueue& operator = (EventQueue&& other) noexcept = default;
+
+    /// \brief Exchange the storage and entries with another EventQueue.
+    ///
+    /// This does not allocate or copy any entries.
+    ///
+    /// \param other The EventQueue to swap with.
+    void swap(EventQueue& other) noexcept;
+
+    /// \brief Add a pointer event to the back of the queue.
+    /// \param e The pointer event to add.
+    void push(const PointerEventArgs& e);
+
+    /// \brief Add a key event to the back of the queue.
+    /// \param e The key event to add.
+    void push(const ofKeyEventArgs& e);
+
+    /// \returns the entry at the front of the queue.
+    /// \throws DOMException if the queue is empty.
+    Entry& front();
+
+    /// \brief Remove the entry at the front of the queue.
+    void pop();
+
+    /// \brief Remove all entries, keeping the storage.
+    void clear();
+
+    /// \returns true if the queue has no entries.
+    bool empty() const;
+
+    /// \returns the number of entries in the queue.
+    std::size_t size() const;
+
+    /// \returns the number of entries that can be queued without allocating.
+    std::size_t capacity() const;
+
+    /// \brief Preallocate storage for a number of entries.
+    /// \param capacity The number of entries, ignored if less than capacity().
+    void reserve(std::size_t capacity);
+
+    /// \brief The default number of preallocated entries.
+    static const std::size_t DEFAULT_CAPACITY;
+
+private:
+    /// \returns a reference to the next free entry, growing if needed.
+    Entry& _pushBack();
+
+    /// \brief The entry storage.
+    std::vector<Entry> _entries;
+
+    /// \brief The index of the front entry.
+    std::size_t _front = 0;
+
+    /// \brief The number of queued entries.
+    std::size_t _size = 0;
+
+};
+
+
+} } // namespace ofx::DOM
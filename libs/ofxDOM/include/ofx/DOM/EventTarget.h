@@ -8,8 +8,10 @@
 #pragma once
 
 
-#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
 #include <string>
+#include <type_traits>
 #include <vector>
 #include "ofx/DOM/Events.h"
 
@@ -25,7 +27,7 @@ namespace DOM {
 ///
 /// \tparam EventTargetType The type of the Tvent target.
 template <class EventTargetType>
-class EventTarget
+class EventTarget: public DOMEventOwner
 {
 public:
     /// \brief Create an EventTarget.
@@ -40,7 +42,8 @@ public:
                           bool useCapture = false,
                           int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofAddListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        ofAddListener(event._event(useCapture), listener<ListenerClass>(), listenerMethod, priority);
+        updateListenerCounts(&event);
     }
 
     template <class EventType, typename ArgumentsType, class ListenerClass>
@@ -49,7 +52,8 @@ public:
                           bool useCapture = false,
                           int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofAddListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        ofAddListener(event._event(useCapture), listener<ListenerClass>(), listenerMethod, priority);
+        updateListenerCounts(&event);
     }
 
     template <class EventType, typename ArgumentsType, class ListenerClass>
@@ -58,7 +62,8 @@ public:
                           bool useCapture = false,
                           int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofAddListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        ofAddListener(event._event(useCapture), listener<ListenerClass>(), listenerMethod, priority);
+        updateListenerCounts(&event);
     }
 
     template <class EventType, typename ArgumentsType, class ListenerClass>
@@ -67,7 +72,8 @@ public:
                           bool useCapture = false,
                           int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofAddListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        ofAddListener(event._event(useCapture), listener<ListenerClass>(), listenerMethod, priority);
+        updateListenerCounts(&event);
     }
 
     template <class EventType, typename ArgumentsType, class ListenerClass>
@@ -76,7 +82,12 @@ public:
                              bool useCapture = false,
                              int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofRemoveListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        // An event that was never created has no listeners to remove.
+        if (auto _event = event.findEvent(useCapture))
+        {
+            ofRemoveListener(*_event, listener<ListenerClass>(), listenerMethod, priority);
+            updateListenerCounts(&event);
+        }
     }
 
     template <class EventType, typename ArgumentsType, class ListenerClass>
@@ -85,7 +96,12 @@ public:
                              bool useCapture = false,
                              int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofRemoveListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        // An event that was never created has no listeners to remove.
+        if (auto _event = event.findEvent(useCapture))
+        {
+            ofRemoveListener(*_event, listener<ListenerClass>(), listenerMethod, priority);
+            updateListenerCounts(&event);
+        }
     }
 
 
@@ -95,7 +111,12 @@ public:
                              bool useCapture = false,
                              int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofRemoveListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        // An event that was never created has no listeners to remove.
+        if (auto _event = event.findEvent(useCapture))
+        {
+            ofRemoveListener(*_event, listener<ListenerClass>(), listenerMethod, priority);
+            updateListenerCounts(&event);
+        }
     }
 
 
@@ -105,7 +126,12 @@ public:
                              bool useCapture = false,
                              int priority = OF_EVENT_ORDER_AFTER_APP)
     {
-        ofRemoveListener(event.event(useCapture), dynamic_cast<ListenerClass*>(this), listenerMethod, priority);
+        // An event that was never created has no listeners to remove.
+        if (auto _event = event.findEvent(useCapture))
+        {
+            ofRemoveListener(*_event, listener<ListenerClass>(), listenerMethod, priority);
+            updateListenerCounts(&event);
+        }
     }
 
     /// \brief Dispatch the given event.
@@ -113,6 +139,11 @@ public:
     /// This will return true if the default action for this event should be
     /// prevented.
     ///
+    /// The propagation path is stored inline for trees up to
+    /// INLINE_PATH_CAPACITY deep, so dispatch does not allocate. Targets
+    /// without listeners for the event's phase are skipped, as are whole
+    /// phases when no target in the tree listens to them.
+    ///
     /// \param event The Event to dispatch.
     /// \tparam EventType The Event type to dispatch.
     /// \returns true iff one of the responders called Event::preventDefault().
@@ -135,20 +166,61 @@ public:
     /// \returns true if it has registered listeners for this event.
     bool hasListenersForEventType(const std::string& type) const;
 
+    /// \brief Determine if the EventTarget has listeners for an event.
+    /// \param type The interned event type.
+    /// \returns true if it has registered listeners for this event.
+    bool hasListenersForEventType(EventTypeId type) const;
+
     /// \brief Determine if the EventTarget is registered to receive the type of events.
     /// \param type The event type.
     /// \returns true if it is registered to receive the type of events.
     bool isEventTypeRegistered(const std::string& type) const;
 
+    /// \brief Determine if the EventTarget is registered to receive the type of events.
+    /// \param type The interned event type.
+    /// \returns true if it is registered to receive the type of events.
+    bool isEventTypeRegistered(EventTypeId type) const;
+
     /// \brief Register a new event type by name.
     /// \param type The event type.
     /// \param event A pointer to the DOMEvent<> that will be called.
     void registerEventType(const std::string& type, BaseDOMEvent* event);
 
+    /// \brief Register a new event type by its interned id.
+    /// \param type The interned event type.
+    /// \param event A pointer to the DOMEvent<> that will be called.
+    void registerEventType(EventTypeId type, BaseDOMEvent* event);
+
     /// \brief Unregister a new event type by name.
     /// \param type The event type.
     void unregisterEventType(const std::string& type);
 
+    /// \brief Unregister a new event type by its interned id.
+    /// \param type The interned event type.
+    void unregisterEventType(EventTypeId type);
+
+    /// \brief Determine if this EventTarget or its descendants have listeners.
+    /// \param type The interned event type.
+    /// \param useCapture True to query capture phase listeners.
+    /// \returns true if any target in this subtree has listeners for the phase.
+    bool hasSubtreeListenersForEventType(EventTypeId type, bool useCapture) const;
+
+    /// \brief Update the listener counts for a registered event.
+    ///
+    /// This is called automatically by addEventListener(),
+    /// removeEventListener() and DOMEvent::event().
+    ///
+    /// \param event The event whose listeners have changed.
+    void updateListenerCounts(const BaseDOMEvent* event);
+
+    void eventListenersChanged(const BaseDOMEvent* event) override;
+
+    /// \brief The depth up to which dispatch paths are stored without allocation.
+    enum
+    {
+        INLINE_PATH_CAPACITY = 32
+    };
+
     virtual void onSetup()
     {
     }
@@ -191,10 +263,12 @@ public:
     ofEvent<ElementOrderEventArgs> reordered;
 
     ofEvent<ElementEventArgs> siblingAdded;
+    ofEvent<ElementListEventArgs> siblingsAdded;
     ofEvent<ElementEventArgs> siblingRemoved;
     ofEvent<ElementOrderEventArgs> siblingReordered;
 
     ofEvent<ElementEventArgs> childAdded;
+    ofEvent<ElementListEventArgs> childrenAdded;
     ofEvent<ElementEventArgs> childRemoved;
     ofEvent<ElementOrderEventArgs> childReordered;
 
@@ -209,7 +283,108 @@ public:
     ofEvent<EnablerEventArgs> hidden;
 
 protected:
-    std::unordered_map<std::string, BaseDOMEvent*> _eventRegistry;
+    /// \brief Get this target as a listener class.
+    ///
+    /// This is only used when listeners are added or removed, so the
+    /// dynamic_cast is not on the dispatch path. A static_cast would be
+    /// undefined if this target is not a ListenerClass, e.g. when the method
+    /// belongs to a sibling class.
+    ///
+    /// \tparam ListenerClass The class of the listener method.
+    /// \returns this target as a ListenerClass or nullptr if it is not one.
+    template <class ListenerClass>
+    ListenerClass* listener()
+    {
+        return dynamic_cast<ListenerClass*>(this);
+    }
+
+    /// \brief Listener counts for a single event type.
+    struct ListenerCounts
+    {
+        /// \brief True if this target may have capture phase listeners.
+        bool capture = false;
+
+        /// \brief True if this target may have bubble phase listeners.
+        bool bubble = false;
+
+        /// \brief The number of targets in this subtree with capture phase listeners.
+        std::size_t subtreeCapture = 0;
+
+        /// \brief The number of targets in this subtree with bubble phase listeners.
+        std::size_t subtreeBubble = 0;
+    };
+
+    /// \brief Recalculate the listener counts for an event type.
+    ///
+    /// If the listeners on this target have changed, the subtree counts of
+    /// this target and all of its ancestors are updated.
+    ///
+    /// \param type The interned event type.
+    void updateListenerCounts(EventTypeId type);
+
+    /// \brief Add or remove the subtree counts of a target to this target.
+    ///
+    /// This must be called when a child is attached to or detached from this
+    /// target. The counts of this target and all of its ancestors are updated.
+    ///
+    /// \param subtree The attached or detached child.
+    /// \param attached True if the child was attached.
+    void updateSubtreeListenerCounts(const EventTarget& subtree, bool attached);
+
+    /// \returns true if this target has listeners for the event type and phase.
+    /// \param type The interned event type.
+    /// \param phase The event phase.
+    bool hasListenersForPhase(EventTypeId type, EventArgs::Phase phase) const;
+
+    /// \brief Find the registered event for an event type.
+    /// \param type The interned event type.
+    /// \returns the registered event or nullptr if none.
+    BaseDOMEvent* findEvent(EventTypeId type);
+
+    /// \brief Find the registered event for an event type.
+    /// \param type The interned event type.
+    /// \returns the registered event or nullptr if none.
+    const BaseDOMEvent* findEvent(EventTypeId type) const;
+
+    /// \brief Find the default event for a built-in event type.
+    ///
+    /// The built-in events are resolved with a static table rather than a
+    /// per-instance registry, so constructing an EventTarget does not
+    /// allocate any registry storage.
+    ///
+    /// \param type The interned event type.
+    /// \returns the member event or nullptr if the type has no default event.
+    BaseDOMEvent* findBuiltInEvent(EventTypeId type);
+
+    /// \brief Find the default event for a built-in event type.
+    /// \param type The interned event type.
+    /// \returns the member event or nullptr if the type has no default event.
+    const BaseDOMEvent* findBuiltInEvent(EventTypeId type) const;
+
+    /// \brief Find the default event for a built-in event type of a target.
+    /// \tparam Target EventTarget or const EventTarget.
+    /// \param target The target to search.
+    /// \param type The interned event type.
+    /// \returns the member event or nullptr if the type has no default event.
+    template <class Target>
+    static typename std::conditional<std::is_const<Target>::value, const BaseDOMEvent*, BaseDOMEvent*>::type
+    findBuiltInEvent(Target& target, EventTypeId type);
+
+    /// \brief Events registered with registerEventType(), indexed by type.
+    ///
+    /// This is empty unless custom events are registered. Entries here take
+    /// precedence over the built-in events.
+    std::vector<BaseDOMEvent*> _eventRegistry;
+
+    /// \brief A bit for each built-in event type that was unregistered.
+    uint32_t _unregisteredBuiltInTypes = 0;
+
+    /// \brief The listener counts, indexed by type.
+    ///
+    /// This is empty until a listener is added to this target or its subtree.
+    std::vector<ListenerCounts> _listenerCounts;
+
+    static_assert(EventTypeRegistry::NUM_BUILT_IN_TYPES <= 32, "Too many built-in event types.");
 
 };
 
@@ -224,29 +399,30 @@ EventTarget<EventTargetType>::EventTarget()
     // to have each one.
 
     // theoretically not having any events registered woudl make isEventTypeRegistered much faster.
-    _eventRegistry = {
-        { PointerEventArgs::POINTER_OVER, &pointerOver },
-        { PointerEventArgs::POINTER_ENTER, &pointerEnter },
-        { PointerEventArgs::POINTER_DOWN, &pointerDown },
-        { PointerEventArgs::POINTER_MOVE, &pointerMove },
-        { PointerEventArgs::POINTER_UP, &pointerUp },
-        { PointerEventArgs::POINTER_CANCEL, &pointerCancel },
-        { PointerEventArgs::POINTER_OUT, &pointerOut },
-        { PointerEventArgs::POINTER_LEAVE, &pointerLeave },
-        { PointerEventArgs::POINTER_SCROLL, &pointerScroll },
-
-        { PointerEventArgs::GOT_POINTER_CAPTURE, &gotPointerCapture },
-        { PointerEventArgs::LOST_POINTER_CAPTURE, &lostPointerCapture },
-
-        { KeyboardUIEventArgs::KEY_DOWN, &keyDown },
-        { KeyboardUIEventArgs::KEY_UP, &keyUp }
-    };
+    //
+    // The default events are registered statically via findBuiltInEvent().
+
+    for (EventTypeId type = 0; type < EventTypeRegistry::NUM_BUILT_IN_TYPES; ++type)
+    {
+        if (BaseDOMEvent* event = findBuiltInEvent(type))
+        {
+            event->setOwner(this);
+        }
+    }
 }
 
 
 template <class EventTargetType>
 EventTarget<EventTargetType>::~EventTarget()
 {
+    // Registered events may outlive this target.
+    for (BaseDOMEvent* event: _eventRegistry)
+    {
+        if (event != nullptr && event->owner() == this)
+        {
+            event->setOwner(nullptr);
+        }
+    }
 }
 
 
@@ -254,39 +430,90 @@ template <class EventTargetType>
 template <class EventType>
 bool EventTarget<EventTargetType>::dispatchEvent(EventType& event)
 {
-    // Get the target (this Element).
-    EventTargetType* target = dynamic_cast<EventTargetType*>(this);
+    // Get the target (this Element). The EventTargetType is always derived
+    // from this class, so no runtime type check is needed.
+    EventTargetType* target = static_cast<EventTargetType*>(this);
+
+    // Count the targets from the target to the document.
+    std::size_t numTargets = 0;
+
+    EventTargetType* root = target;
+
+    for (EventTargetType* t = target; t != nullptr; t = t->parent())
+    {
+        root = t;
+        ++numTargets;
+    }
+
+    // The subtree counts of the root cover every target on the path.
+    EventTypeId type = event.typeId();
+
+    const EventTarget* rootTarget = root;
+
+    bool hasCaptureListeners = rootTarget->hasSubtreeListenersForEventType(type, true);
+    bool hasBubbleListeners = rootTarget->hasSubtreeListenersForEventType(type, false);
+
+    // If nothing listens to this event, there is nothing to dispatch.
+    if (!hasCaptureListeners && !hasBubbleListeners)
+    {
+        return event.isDefaultPrevented();
+    }
+
+    // Create the path from the target to the document. The path is stored
+    // inline unless the tree is unusually deep.
+    EventTargetType* inlineTargets[INLINE_PATH_CAPACITY];
+    std::vector<EventTargetType*> overflowTargets;
 
-    // Create the path from the target to the document.
-    std::vector<EventTargetType*> targets;
+    EventTargetType** targets = inlineTargets;
+
+    if (numTargets > INLINE_PATH_CAPACITY)
+    {
+        overflowTargets.resize(numTargets);
+        targets = overflowTargets.data();
+    }
 
     // The target will be at the beginning of the list.
     // The root document will be at the end of the list.
-    do
+    for (std::size_t i = 0; i < numTargets; ++i)
     {
-        targets.push_back(target);
+        targets[i] = target;
         target = target->parent();
     }
-    while (target);
 
 
     // Capture and Target phase (document -> target).
 
     // Begin with the document (at the end of the list).
-    auto riter = targets.rbegin();
+    std::size_t index = numTargets;
 
     // Cycle through the targets from the document to the event.target().
-    while (riter != targets.rend())
+    while (index-- > 0)
     {
-        event.setPhase(event.target() == *riter ? EventArgs::Phase::AT_TARGET : EventArgs::Phase::CAPTURING_PHASE);
-        event.setCurrentTarget(*riter);
+        EventTargetType* currentTarget = targets[index];
+
+        EventArgs::Phase phase = event.target() == currentTarget ? EventArgs::Phase::AT_TARGET : EventArgs::Phase::CAPTURING_PHASE;
+
+        // Only the target itself can have bubble listeners in this phase.
+        if (!hasCaptureListeners && phase != EventArgs::Phase::AT_TARGET)
+        {
+            continue;
+        }
+
+        // Skip targets that have no listeners for this phase.
+        if (!static_cast<const EventTarget*>(currentTarget)->hasListenersForPhase(type, phase))
+        {
+            continue;
+        }
+
+        event.setPhase(phase);
+        event.setCurrentTarget(currentTarget);
 
         // Here we handle event and assume that if the currentTarget
         // can't handle the event, it will return quickly with no errors.
         // This is potentially faster that asking the target to search its
         // registry and then asking it to search its registry _again_ to
         // actually handle the event.
-        bool isRegisteredHandler = (*riter)->handleEvent(event);
+        bool isRegisteredHandler = currentTarget->handleEvent(event);
 
         // If the event is cancelled, return appropriately.
         if (event.isCancelled())
@@ -301,37 +528,36 @@ bool EventTarget<EventTargetType>::dispatchEvent(EventType& event)
             // Does this prevent us from dynamically adding and removing listeners between the
             // bubble and capture phases though?
         }
-        
-        // Continue iterating.
-        ++riter;
     }
 
     // Bubble phase if needed (target -> document).
-    if (targets.size() > 1 && event.bubbles())
+    if (numTargets > 1 && event.bubbles() && hasBubbleListeners)
     {
         // Begin with the _parent_ of the target element (we already dealt
         // with the target element during the capture / target phased).
-        auto bubbleIter = targets.begin() + 1;
-
-        while (bubbleIter != targets.end())
+        for (std::size_t bubbleIndex = 1; bubbleIndex < numTargets; ++bubbleIndex)
         {
+            // Skip targets that have no listeners for this phase.
+            if (!static_cast<const EventTarget*>(targets[bubbleIndex])->hasListenersForPhase(type, EventArgs::Phase::BUBBLING_PHASE))
+            {
+                continue;
+            }
+
             event.setPhase(EventArgs::Phase::BUBBLING_PHASE);
 
-            event.setCurrentTarget(*bubbleIter);
+            event.setCurrentTarget(targets[bubbleIndex]);
 
             // Here we handle event and assume that if the currentTarget
             // can't handle the event, it will return quickly with no errors.
             // This is potentially faster that asking the target to search its
             // registry and then asking it to search its registry _again_ to
             // actually handle the event.
-            (*bubbleIter)->handleEvent(event);
+            targets[bubbleIndex]->handleEvent(event);
 
             if (event.isCancelled())
             {
                 return !event.isDefaultPrevented();
             }
-            
-            ++bubbleIter;
         }
     }
     
@@ -342,11 +568,18 @@ bool EventTarget<EventTargetType>::dispatchEvent(EventType& event)
 template <class EventTargetType>
 bool EventTarget<EventTargetType>::hasListenersForEventType(const std::string& type) const
 {
-    auto iter = _eventRegistry.find(type);
+    return hasListenersForEventType(EventTypeRegistry::idForType(type));
+}
+
+
+template <class EventTargetType>
+bool EventTarget<EventTargetType>::hasListenersForEventType(EventTypeId type) const
+{
+    const BaseDOMEvent* event = findEvent(type);
 
-    if (iter != _eventRegistry.end())
+    if (event != nullptr)
     {
-        return iter->second->hasListeners();
+        return event->hasListeners();
     }
     else
     {
@@ -359,14 +592,15 @@ template <class EventTargetType>
 template <class EventArgsType>
 bool EventTarget<EventTargetType>::handleEvent(EventArgsType& e)
 {
-    auto iter = _eventRegistry.find(e.type());
+    BaseDOMEvent* event = findEvent(e.typeId());
 
-    if (iter != _eventRegistry.end())
+    if (event != nullptr)
     {
-        DOMEvent<EventArgsType>* _event = dynamic_cast<DOMEvent<EventArgsType>*>(iter->second);
-
-        if (_event)
+        // The argument type tag is compared rather than using RTTI.
+        if (event->argsType() == DOMEvent<EventArgsType>::argsTypeTag())
         {
+            DOMEvent<EventArgsType>* _event = static_cast<DOMEvent<EventArgsType>*>(event);
+
 //            if (e.type() == "buttonpressed")
 //            {
 //                cout << "event: " << e.type() << " being handled by : " << (e.getCurrentTarget() ? e.getCurrentTarget()->getId() : "nullptr") << endl;
@@ -391,7 +625,14 @@ bool EventTarget<EventTargetType>::handleEvent(EventArgsType& e)
 template <class EventTargetType>
 bool EventTarget<EventTargetType>::isEventTypeRegistered(const std::string& type) const
 {
-    return _eventRegistry.find(type) != _eventRegistry.end();
+    return isEventTypeRegistered(EventTypeRegistry::idForType(type));
+}
+
+
+template <class EventTargetType>
+bool EventTarget<EventTargetType>::isEventTypeRegistered(EventTypeId type) const
+{
+    return findEvent(type) != nullptr;
 }
 
 
@@ -399,14 +640,309 @@ template <class EventTargetType>
 void EventTarget<EventTargetType>::registerEventType(const std::string& type,
                                                      BaseDOMEvent* event)
 {
+    registerEventType(EventTypeRegistry::idForType(type), event);
+}
+
+
+template <class EventTargetType>
+void EventTarget<EventTargetType>::registerEventType(EventTypeId type,
+                                                     BaseDOMEvent* event)
+{
+    if (type >= _eventRegistry.size())
+    {
+        _eventRegistry.resize(type + 1, nullptr);
+    }
+
     _eventRegistry[type] = event;
+
+    if (event != nullptr)
+    {
+        event->setOwner(this);
+    }
+
+    if (type < EventTypeRegistry::NUM_BUILT_IN_TYPES)
+    {
+        _unregisteredBuiltInTypes &= ~(uint32_t(1) << type);
+    }
+
+    updateListenerCounts(type);
 }
 
 
 template <class EventTargetType>
 void EventTarget<EventTargetType>::unregisterEventType(const std::string& type)
 {
-    _eventRegistry.erase(_eventRegistry.find(type));
+    unregisterEventType(EventTypeRegistry::idForType(type));
+}
+
+
+template <class EventTargetType>
+void EventTarget<EventTargetType>::unregisterEventType(EventTypeId type)
+{
+    if (type < _eventRegistry.size())
+    {
+        BaseDOMEvent* event = _eventRegistry[type];
+
+        if (event != nullptr && event->owner() == this)
+        {
+            event->setOwner(nullptr);
+        }
+
+        _eventRegistry[type] = nullptr;
+    }
+
+    if (type < EventTypeRegistry::NUM_BUILT_IN_TYPES)
+    {
+        _unregisteredBuiltInTypes |= (uint32_t(1) << type);
+    }
+
+    updateListenerCounts(type);
+}
+
+
+template <class EventTargetType>
+bool EventTarget<EventTargetType>::hasSubtreeListenersForEventType(EventTypeId type,
+                                                                   bool useCapture) const
+{
+    if (type < _listenerCounts.size())
+    {
+        const ListenerCounts& counts = _listenerCounts[type];
+        return (useCapture ? counts.subtreeCapture : counts.subtreeBubble) > 0;
+    }
+
+    return false;
+}
+
+
+template <class EventTargetType>
+void EventTarget<EventTargetType>::updateListenerCounts(const BaseDOMEvent* event)
+{
+    // Events are rarely added or removed, so a scan of the types is cheap.
+    std::size_t numTypes = std::max(_eventRegistry.size(),
+                                    std::size_t(EventTypeRegistry::NUM_BUILT_IN_TYPES));
+
+    for (EventTypeId type = 0; type < numTypes; ++type)
+    {
+        if (findEvent(type) == event)
+        {
+            updateListenerCounts(type);
+        }
+    }
+}
+
+
+template <class EventTargetType>
+void EventTarget<EventTargetType>::eventListenersChanged(const BaseDOMEvent* event)
+{
+    updateListenerCounts(event);
+}
+
+
+template <class EventTargetType>
+void EventTarget<EventTargetType>::updateListenerCounts(EventTypeId type)
+{
+    BaseDOMEvent* event = findEvent(type);
+
+    bool capture = event != nullptr && event->mayHaveCapturePhaseListeners();
+    bool bubble = event != nullptr && event->mayHaveBubblePhaseListeners();
+
+    if (type >= _listenerCounts.size())
+    {
+        if (!capture && !bubble)
+        {
+            return;
+        }
+
+        _listenerCounts.resize(type + 1);
+    }
+
+    ListenerCounts& counts = _listenerCounts[type];
+
+    if (counts.capture == capture && counts.bubble == bubble)
+    {
+        return;
+    }
+
+    bool captureChanged = counts.capture != capture;
+    bool bubbleChanged = counts.bubble != bubble;
+
+    counts.capture = capture;
+    counts.bubble = bubble;
+
+    // Update this target and its ancestors.
+    for (EventTarget* target = this;
+         target != nullptr;
+         target = static_cast<EventTargetType*>(target)->parent())
+    {
+        if (type >= target->_listenerCounts.size())
+        {
+            target->_listenerCounts.resize(type + 1);
+        }
+
+        ListenerCounts& targetCounts = target->_listenerCounts[type];
+
+        if (captureChanged)
+        {
+            capture ? ++targetCounts.subtreeCapture : --targetCounts.subtreeCapture;
+        }
+
+        if (bubbleChanged)
+        {
+            bubble ? ++targetCounts.subtreeBubble : --targetCounts.subtreeBubble;
+        }
+    }
+}
+
+
+template <class EventTargetType>
+void EventTarget<EventTargetType>::updateSubtreeListenerCounts(const EventTarget& subtree,
+                                                               bool attached)
+{
+    if (subtree._listenerCounts.empty())
+    {
+        return;
+    }
+
+    for (EventTarget* target = this;
+         target != nullptr;
+         target = static_cast<EventTargetType*>(target)->parent())
+    {
+        if (subtree._listenerCounts.size() > target->_listenerCounts.size())
+        {
+            target->_listenerCounts.resize(subtree._listenerCounts.size());
+        }
+
+        for (std::size_t type = 0; type < subtree._listenerCounts.size(); ++type)
+        {
+            const ListenerCounts& subtreeCounts = subtree._listenerCounts[type];
+            ListenerCounts& targetCounts = target->_listenerCounts[type];
+
+            if (attached)
+            {
+                targetCounts.subtreeCapture += subtreeCounts.subtreeCapture;
+                targetCounts.subtreeBubble += subtreeCounts.subtreeBubble;
+            }
+            else
+            {
+                targetCounts.subtreeCapture -= subtreeCounts.subtreeCapture;
+                targetCounts.subtreeBubble -= subtreeCounts.subtreeBubble;
+            }
+        }
+    }
+}
+
+
+template <class EventTargetType>
+bool EventTarget<EventTargetType>::hasListenersForPhase(EventTypeId type,
+                                                        EventArgs::Phase phase) const
+{
+    if (type >= _listenerCounts.size())
+    {
+        return false;
+    }
+
+    const ListenerCounts& counts = _listenerCounts[type];
+
+    switch (phase)
+    {
+        case EventArgs::Phase::CAPTURING_PHASE:
+            return counts.capture;
+        case EventArgs::Phase::AT_TARGET:
+            return counts.capture || counts.bubble;
+        case EventArgs::Phase::BUBBLING_PHASE:
+            return counts.bubble;
+        case EventArgs::Phase::NONE:
+            break;
+    }
+
+    return false;
+}
+
+
+template <class EventTargetType>
+BaseDOMEvent* EventTarget<EventTargetType>::findEvent(EventTypeId type)
+{
+    if (type < _eventRegistry.size() && _eventRegistry[type] != nullptr)
+    {
+        return _eventRegistry[type];
+    }
+    else if (type < EventTypeRegistry::NUM_BUILT_IN_TYPES
+         && !(_unregisteredBuiltInTypes & (uint32_t(1) << type)))
+    {
+        return findBuiltInEvent(type);
+    }
+
+    return nullptr;
+}
+
+
+template <class EventTargetType>
+const BaseDOMEvent* EventTarget<EventTargetType>::findEvent(EventTypeId type) const
+{
+    if (type < _eventRegistry.size() && _eventRegistry[type] != nullptr)
+    {
+        return _eventRegistry[type];
+    }
+    else if (type < EventTypeRegistry::NUM_BUILT_IN_TYPES
+         && !(_unregisteredBuiltInTypes & (uint32_t(1) << type)))
+    {
+        return findBuiltInEvent(type);
+    }
+
+    return nullptr;
+}
+
+
+template <class EventTargetType>
+BaseDOMEvent* EventTarget<EventTargetType>::findBuiltInEvent(EventTypeId type)
+{
+    return findBuiltInEvent(*this, type);
+}
+
+
+template <class EventTargetType>
+const BaseDOMEvent* EventTarget<EventTargetType>::findBuiltInEvent(EventTypeId type) const
+{
+    return findBuiltInEvent(*this, type);
+}
+
+
+template <class EventTargetType>
+template <class Target>
+typename std::conditional<std::is_const<Target>::value, const BaseDOMEvent*, BaseDOMEvent*>::type
+EventTarget<EventTargetType>::findBuiltInEvent(Target& target, EventTypeId type)
+{
+    switch (type)
+    {
+        case EventTypeRegistry::POINTER_OVER:
+            return &target.pointerOver;
+        case EventTypeRegistry::POINTER_ENTER:
+            return &target.pointerEnter;
+        case EventTypeRegistry::POINTER_DOWN:
+            return &target.pointerDown;
+        case EventTypeRegistry::POINTER_MOVE:
+            return &target.pointerMove;
+        case EventTypeRegistry::POINTER_UP:
+            return &target.pointerUp;
+        case EventTypeRegistry::POINTER_CANCEL:
+            return &target.pointerCancel;
+        case EventTypeRegistry::POINTER_OUT:
+            return &target.pointerOut;
+        case EventTypeRegistry::POINTER_LEAVE:
+            return &target.pointerLeave;
+        case EventTypeRegistry::POINTER_SCROLL:
+            return &target.pointerScroll;
+        case EventTypeRegistry::GOT_POINTER_CAPTURE:
+            return &target.gotPointerCapture;
+        case EventTypeRegistry::LOST_POINTER_CAPTURE:
+            return &target.lostPointerCapture;
+        case EventTypeRegistry::KEY_DOWN:
+            return &target.keyDown;
+        case EventTypeRegistry::KEY_UP:
+            return &target.keyUp;
+        default:
+            return nullptr;
+    }
 }
 
 
@@ -8,9 +8,14 @@
 #pragma once
 
 
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <type_traits>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 #include <ctime>
 #include "ofEvents.h"
 #include "ofx/PointerEvents.h"
@@ -25,6 +30,99 @@ namespace DOM {
 class Element;
 
 
+/// \brief A small integer identifying an interned event type.
+typedef std::size_t EventTypeId;
+
+
+/// \brief A registry of interned event types.
+///
+/// Event type names are converted to small integer ids once, when an event is
+/// created or registered. Event dispatch then uses the ids without hashing,
+/// copying or comparing strings.
+///
+/// The built-in event types are always registered first, so their ids are
+/// compile-time constants.
+class EventTypeRegistry
+{
+public:
+    /// \brief The ids of the built-in event types.
+    enum : EventTypeId
+    {
+        POINTER_OVER = 0,
+        POINTER_ENTER,
+        POINTER_DOWN,
+        POINTER_MOVE,
+        POINTER_UP,
+        POINTER_CANCEL,
+        POINTER_OUT,
+        POINTER_LEAVE,
+        POINTER_SCROLL,
+        GOT_POINTER_CAPTURE,
+        LOST_POINTER_CAPTURE,
+        KEY_DOWN,
+        KEY_UP,
+        FOCUS_IN,
+        FOCUS,
+        FOCUS_OUT,
+        BLUR,
+        NUM_BUILT_IN_TYPES
+    };
+
+    /// \brief Get the id for an event type, registering it if needed.
+    ///
+    /// Built-in types are found in an immutable table without locking. Only
+    /// custom types take the registry lock.
+    ///
+    /// \param type The event type name.
+    /// \returns the id of the event type.
+    static EventTypeId idForType(const std::string& type);
+
+    /// \brief Get the name of an event type.
+    /// \param id The id of the event type.
+    /// \returns the event type name.
+    /// \throws DOMException if the id is not registered.
+    static const std::string& typeForId(EventTypeId id);
+
+    /// \returns the number of registered event types.
+    static std::size_t size();
+
+private:
+    /// \brief The built-in event types, which never change after creation.
+    struct BuiltInTypes
+    {
+        /// \brief Create the table of built-in types.
+        BuiltInTypes();
+
+        /// \brief Map built-in event type names to their ids.
+        std::unordered_map<std::string, EventTypeId> ids;
+
+        /// \brief Built-in event type names indexed by id.
+        std::vector<std::string> types;
+    };
+
+    /// \brief Create an empty registry of custom types.
+    EventTypeRegistry();
+
+    /// \returns the shared registry of custom types.
+    static EventTypeRegistry& instance();
+
+    /// \returns the shared table of built-in types.
+    static const BuiltInTypes& builtInTypes();
+
+    /// \brief Map custom event type names to their ids.
+    std::unordered_map<std::string, EventTypeId> _ids;
+
+    /// \brief Custom event type names indexed by id - NUM_BUILT_IN_TYPES.
+    ///
+    /// A deque is used so that references to the names remain valid.
+    std::deque<std::string> _types;
+
+    /// \brief Events may be created on any thread.
+    mutable std::mutex _mutex;
+
+};
+
+
 /// \brief The base type describing a named Element Event.
 ///
 /// \sa http://www.w3.org/TR/DOM-Level-3-Events/
@@ -60,6 +158,36 @@ public:
               bool cancelable,
               uint64_t timestamp);
 
+    /// \brief Create EventArgs with an interned type.
+    /// \param type The event type id.
+    /// \param source The source Element.
+    /// \param target The target Element.
+    /// \param bubbles True iff the argument bubbles after AT_TARGET phase.
+    /// \param cancelable True iff the event can be cancelled by a listener.
+    /// \param timestamp The timestamp of the event.
+    EventArgs(EventTypeId type,
+              Element* source,
+              Element* target,
+              bool bubbles,
+              bool cancelable,
+              uint64_t timestamp);
+
+    /// \brief Create EventArgs with an interned type.
+    /// \param type The event type id.
+    /// \param source The source Element.
+    /// \param target The target Element.
+    /// \param relatedTarget The related target Element.
+    /// \param bubbles True iff the argument bubbles after AT_TARGET phase.
+    /// \param cancelable True iff the event can be cancelled by a listener.
+    /// \param timestamp The timestamp of the event.
+    EventArgs(EventTypeId type,
+              Element* source,
+              Element* target,
+              Element* relatedTarget,
+              bool bubbles,
+              bool cancelable,
+              uint64_t timestamp);
+
     /// \brief Destroy the EventArgs.
     virtual ~EventArgs();
 
@@ -67,6 +195,10 @@ public:
     /// \returns the event type string.
     const std::string& type() const;
 
+    /// \brief Get the interned event type.
+    /// \returns the event type id.
+    EventTypeId typeId() const;
+
     enum class Phase
     {
         /// \brief Events not currently dispatched are in this phase.
@@ -159,8 +291,8 @@ public:
     virtual std::string toString() const;
 
 protected:
-    /// \brief The name of the event (case-insensitive).
-    std::string _type;
+    /// \brief The interned type of the event.
+    EventTypeId _typeId = 0;
 
     /// \brief The source of the event.
     Element* _source = nullptr;
@@ -241,9 +373,21 @@ private:
 };
 
 
+/// \brief A DOM pointer event.
+///
+/// The event refers to the source PointerEventArgs rather than copying it,
+/// so the pointer data is only valid while the event is being dispatched.
+/// A copy of the event refers to the same pointer data, so listeners that
+/// keep an event must copy pointer() instead.
+///
+/// Synthesized pointerover, pointerenter, pointerout and pointerleave events
+/// share the pointer data of the event that caused them, so their
+/// pointer().eventType() is that of the causing event (e.g. pointermove).
+/// Use type() for the type of the DOM event itself.
 class PointerUIEventArgs: public UIEventArgs
 {
 public:
+    /// \param args The source pointer data, which must outlive this event.
     /// \param source The source Element.
     /// \param target The target Element.
     PointerUIEventArgs(const PointerEventArgs& args,
@@ -251,19 +395,82 @@ public:
                        Element* target,
                        Element* relatedTarget = nullptr);
 
+    /// \brief Create an event whose type may differ from args.eventType().
+    ///
+    /// This is used for synthesized events (e.g. pointerover) that share the
+    /// pointer data of the event that caused them.
+    ///
+    /// \param type The interned event type.
+    /// \param args The source pointer data, which must outlive this event.
+    /// \param source The source Element.
+    /// \param target The target Element.
+    PointerUIEventArgs(EventTypeId type,
+                       const PointerEventArgs& args,
+                       Element* source,
+                       Element* target,
+                       Element* relatedTarget = nullptr);
+
+    /// \brief Temporary pointer data would not outlive the event.
+    PointerUIEventArgs(const PointerEventArgs&& args,
+                       Element* source,
+                       Element* target,
+                       Element* relatedTarget = nullptr) = delete;
+
+    /// \brief Temporary pointer data would not outlive the event.
+    PointerUIEventArgs(EventTypeId type,
+                       const PointerEventArgs&& args,
+                       Element* source,
+                       Element* target,
+                       Element* relatedTarget = nullptr) = delete;
+
     virtual ~PointerUIEventArgs();
 
+    /// \brief Get the source pointer data.
+    ///
+    /// For synthesized events, the pointer data is that of the event that
+    /// caused them, so pointer().eventType() may differ from type().
+    ///
+    /// \returns the source pointer data.
     const PointerEventArgs& pointer() const;
 
     Position screenPosition() const;
 
     Position localPosition() const;
 
+    /// \brief Get the raw samples that were coalesced into this event.
+    ///
+    /// The samples are in the order they were received and include the
+    /// sample returned by pointer(). The list is empty unless pointermove
+    /// coalescing is enabled on the Document.
+    ///
+    /// \returns the coalesced samples.
+    /// \sa Document::setPointerMoveCoalescing()
+    const std::vector<PointerEventArgs>& coalescedEvents() const;
+
+    /// \brief Get the predicted future positions of the pointer.
+    ///
+    /// The positions are in screen coordinates. The list is empty unless
+    /// pointermove prediction is enabled on the Document.
+    ///
+    /// \returns the predicted positions.
+    /// \sa Document::setPointerMovePredictionCount()
+    const std::vector<Position>& predictedPositions() const;
+
 protected:
-    static bool eventBubbles(const std::string& event);
-    static bool eventCancelable(const std::string& event);
+    static bool eventBubbles(EventTypeId event);
+    static bool eventCancelable(EventTypeId event);
+
+    /// \brief The source pointer data, owned by the caller.
+    const PointerEventArgs* _pointer = nullptr;
 
-    PointerEventArgs _pointer;
+    /// \brief The coalesced samples, owned by the Document, or nullptr if none.
+    const std::vector<PointerEventArgs>* _coalescedEvents = nullptr;
+
+    /// \brief The predicted positions, owned by the Document, or nullptr if none.
+    const std::vector<Position>* _predictedPositions = nullptr;
+
+    /// \brief The Document class has access to the coalesced samples.
+    friend class Document;
 
 };
 
@@ -315,6 +522,14 @@ public:
                    Element* target,
                    Element* relatedTarget = nullptr);
 
+    /// \param type The interned event type.
+    /// \param source The source Element.
+    /// \param target The target Element.
+    FocusEventArgs(EventTypeId type,
+                   Element* source,
+                   Element* target,
+                   Element* relatedTarget = nullptr);
+
     virtual ~FocusEventArgs();
 
     static const std::string FOCUS_IN;
@@ -342,13 +557,48 @@ public:
 
 
 
+class BaseDOMEvent;
+
+
+/// \brief An object that is told when the listeners of its events may change.
+class DOMEventOwner
+{
+public:
+    virtual ~DOMEventOwner()
+    {
+    }
+
+    /// \brief Called when the listeners of an owned event may have changed.
+    /// \param event The event whose listeners may have changed.
+    virtual void eventListenersChanged(const BaseDOMEvent* event) = 0;
+
+};
+
+
 class BaseDOMEvent
 {
 public:
+    /// \brief Create a BaseDOMEvent.
+    /// \param argsType The tag identifying the event argument type.
+    BaseDOMEvent(const void* argsType): _argsType(argsType)
+    {
+    }
+
     virtual ~BaseDOMEvent()
     {
     }
 
+    /// \brief Get the tag identifying the event argument type.
+    ///
+    /// Comparing tags allows an event to be safely cast to its DOMEvent<>
+    /// type without RTTI.
+    ///
+    /// \returns the argument type tag.
+    const void* argsType() const
+    {
+        return _argsType;
+    }
+
     //virtual std::string type() const = 0;
 
     /// \returns true if the event has bubble phase listeners.
@@ -363,32 +613,121 @@ public:
         return hasBubblePhaseListeners() || hasCapturePhaseListeners();
     }
 
+    /// \brief Determine if the event may have bubble phase listeners.
+    ///
+    /// Unlike hasBubblePhaseListeners(), this stays true once the underlying
+    /// event has been handed out, since listeners may then be added to it
+    /// without the owner being told.
+    ///
+    /// \returns true if the event may have bubble phase listeners.
+    virtual bool mayHaveBubblePhaseListeners() const = 0;
+
+    /// \brief Determine if the event may have capture phase listeners.
+    /// \returns true if the event may have capture phase listeners.
+    /// \sa mayHaveBubblePhaseListeners()
+    virtual bool mayHaveCapturePhaseListeners() const = 0;
+
+    /// \returns the owner told about listener changes or nullptr if none.
+    DOMEventOwner* owner() const
+    {
+        return _owner;
+    }
+
+    /// \brief Set the owner told about listener changes.
+    /// \param owner The owner or nullptr for none.
+    void setOwner(DOMEventOwner* owner)
+    {
+        _owner = owner;
+    }
+
+private:
+    /// \brief The tag identifying the event argument type.
+    const void* _argsType = nullptr;
+
+    /// \brief The owner told about listener changes or nullptr if none.
+    DOMEventOwner* _owner = nullptr;
+
 };
 
 
 /// \brief DOM Events follow the DOM capture, target, bubble propagation scheme.
+///
+/// The underlying ofEvents are only created when a listener is first added,
+/// since most Elements only listen to a few of their events.
+///
 /// \tparam EventArgsType The Event argument type wrapped this DOMEvent.
 template <typename EventArgsType>
 class DOMEvent: public BaseDOMEvent
 {
 public:
+    DOMEvent(): BaseDOMEvent(argsTypeTag())
+    {
+    }
+
     virtual ~DOMEvent()
     {
     }
 
+    /// \returns the tag identifying EventArgsType.
+    static const void* argsTypeTag()
+    {
+        static const char tag = 0;
+        return &tag;
+    }
+
     bool hasBubblePhaseListeners() const override
     {
-        return _bubbleEvent.size() > 0;
+        return _bubbleEvent && _bubbleEvent->size() > 0;
     }
 
     bool hasCapturePhaseListeners() const override
     {
-        return _captureEvent.size() > 0;
+        return _captureEvent && _captureEvent->size() > 0;
+    }
+
+    bool mayHaveBubblePhaseListeners() const override
+    {
+        return _bubbleEvent && (_bubbleEventExposed || _bubbleEvent->size() > 0);
+    }
+
+    bool mayHaveCapturePhaseListeners() const override
+    {
+        return _captureEvent && (_captureEventExposed || _captureEvent->size() > 0);
+    }
+
+    /// \brief Find the underlying event without creating it.
+    /// \param useCapture True to find the capture phase event.
+    /// \returns the event or nullptr if no listener was ever added to it.
+    ofEvent<EventArgsType>* findEvent(bool useCapture = false)
+    {
+        return useCapture ? _captureEvent.get() : _bubbleEvent.get();
     }
 
+    /// \brief Get the underlying event, creating it if needed.
+    ///
+    /// Listeners may be added to the returned event directly, so from now on
+    /// the owner assumes that this phase has listeners and dispatch never
+    /// skips it.
+    ///
+    /// \param useCapture True to get the capture phase event.
+    /// \returns the event.
     ofEvent<EventArgsType>& event(bool useCapture = false)
     {
-        return useCapture ? _captureEvent : _bubbleEvent;
+        ofEvent<EventArgsType>& event = _event(useCapture);
+
+        bool& exposed = useCapture ? _captureEventExposed : _bubbleEventExposed;
+
+        if (!exposed)
+        {
+            exposed = true;
+
+            if (owner())
+            {
+                owner()->eventListenersChanged(this);
+            }
+        }
+
+        return event;
     }
 
     void notify(EventArgsType& e)
@@ -398,21 +737,48 @@ public:
             case EventArgs::Phase::NONE:
                 throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "DOMEvent::notify");
             case EventArgs::Phase::CAPTURING_PHASE:
-                _captureEvent.notify(e.source(), e);
+                if (_captureEvent) _captureEvent->notify(e.source(), e);
                 return;
             case EventArgs::Phase::AT_TARGET:
-                _captureEvent.notify(e.source(), e);
-                _bubbleEvent.notify(e.source(), e);
+                if (_captureEvent) _captureEvent->notify(e.source(), e);
+                if (_bubbleEvent) _bubbleEvent->notify(e.source(), e);
                 return;
             case EventArgs::Phase::BUBBLING_PHASE:
-                _bubbleEvent.notify(e.source(), e);
+                if (_bubbleEvent) _bubbleEvent->notify(e.source(), e);
                 return;
         }
     }
 
 private:
-    ofEvent<EventArgsType> _bubbleEvent;
-    ofEvent<EventArgsType> _captureEvent;
+    template <class EventTargetType>
+    friend class EventTarget;
+
+    /// \brief Get the underlying event, creating it if needed.
+    ///
+    /// This is used by EventTarget, which updates the listener counts itself.
+    ///
+    /// \param useCapture True to get the capture phase event.
+    /// \returns the event.
+    ofEvent<EventArgsType>& _event(bool useCapture)
+    {
+        std::unique_ptr<ofEvent<EventArgsType>>& event = useCapture ? _captureEvent : _bubbleEvent;
+
+        if (!event)
+        {
+            event = std::make_unique<ofEvent<EventArgsType>>();
+        }
+
+        return *event;
+    }
+
+    std::unique_ptr<ofEvent<EventArgsType>> _bubbleEvent;
+    std::unique_ptr<ofEvent<EventArgsType>> _captureEvent;
+
+    /// \brief True once the bubble phase event was returned by event().
+    bool _bubbleEventExposed = false;
+
+    /// \brief True once the capture phase event was returned by event().
+    bool _captureEventExposed = false;
 
 };
 
@@ -513,6 +879,27 @@ protected:
 };
 
 
+/// \brief Event arguments for operations on several Elements at once.
+class ElementListEventArgs
+{
+public:
+    /// \brief Construct the ElementListEventArgs.
+    /// \param elements The elements associated with this Element event.
+    ElementListEventArgs(std::vector<Element*> elements);
+
+    /// \brief Destroy the ElementListEventArgs.
+    virtual ~ElementListEventArgs();
+
+    /// \returns the elements associated with this Element event.
+    const std::vector<Element*>& elements() const;
+
+protected:
+    /// \brief The elements associated with this Element event.
+    std::vector<Element*> _elements;
+
+};
+
+
 class ElementOrderEventArgs: public ElementEventArgs
 {
 public:
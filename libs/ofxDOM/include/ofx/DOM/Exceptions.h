@@ -34,6 +34,9 @@ public:
     /// \brief Invalid attribute key exception.
     static const std::string INVALID_ATTRIBUTE_KEY;
 
+    /// \brief Invalid selector syntax exception.
+    static const std::string SYNTAX_ERROR;
+
 };
 
 
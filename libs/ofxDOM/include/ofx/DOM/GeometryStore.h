@@ -0,0 +1,187 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <vector>
+#include "ofx/DOM/Types.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+class Element;
+
+
+/// \brief A structure of arrays holding the geometry of a whole Element tree.
+///
+/// Each Element in the tree is assigned a slot. Slots are assigned breadth
+/// first, so a parent's slot always precedes its children's slots and the
+/// children of each Element occupy a contiguous range of slots in child
+/// order. The shape and flags of each slot are packed into separate arrays,
+/// so scans over many Elements touch only the data they need.
+///
+/// Shape and flag changes are written through by the Elements as they happen.
+/// Elements being added or removed requires a full rebuild, which is done
+/// lazily on the next query. Reordering children moves only the slots of the
+/// children between the old and new index. Screen positions and
+/// total shapes are derived lazily in two linear passes over the arrays.
+///
+/// Queries use the rectangular shape of each Element, so Elements that
+/// override Element::hitTest() or Element::childHitTest() are tested as
+/// rectangles.
+///
+/// Generally this class should not be instantiated directly but instead
+/// should be enabled using Document::setGeometryStoreEnabled(true).
+class GeometryStore
+{
+public:
+    /// \brief Create a GeometryStore for the given Element tree.
+    /// \param root The root Element, usually a Document.
+    GeometryStore(Element* root);
+
+    /// \brief Destroy the GeometryStore.
+    ~GeometryStore();
+
+    /// \returns a pointer to the root Element.
+    Element* root();
+
+    /// \brief Mark the whole store as invalid.
+    ///
+    /// This must be called when Elements are added or removed.
+    void invalidate();
+
+    /// \brief Move the slot of a reordered child.
+    ///
+    /// This must be called when a child is reordered. The slots of the
+    /// children between the two indices shift by one place toward the old
+    /// index, and their own children follow them.
+    ///
+    /// \param parent The parent of the reordered child.
+    /// \param oldIndex The child's previous index.
+    /// \param newIndex The child's new index.
+    void moveChild(const Element* parent, std::size_t oldIndex, std::size_t newIndex);
+
+    /// \returns true iff the store does not require a full rebuild.
+    bool isValid() const;
+
+    /// \brief Copy the shape and flags of an Element into its slot.
+    /// \param slot The Element's slot.
+    void update(std::size_t slot);
+
+    /// \returns the number of slots, rebuilding if needed.
+    std::size_t size();
+
+    /// \brief Find the front-most Element containing a position.
+    ///
+    /// This has the same result as Element::recursiveHitTest() on the root
+    /// for Elements that use the default hit tests.
+    ///
+    /// \param screenPosition The position to test in screen coordinates.
+    /// \returns the target Element or nullptr if none.
+    Element* hitTest(const Position& screenPosition);
+
+    /// \brief Find the visible Elements whose shape intersects a rectangle.
+    ///
+    /// Elements are visible if they and all of their ancestors are enabled
+    /// and not hidden. Elements are returned in slot order.
+    ///
+    /// \param screenShape The rectangle to test in screen coordinates.
+    /// \param elements The vector to receive the Elements.
+    /// \returns the number of Elements added.
+    std::size_t cull(const Shape& screenShape, std::vector<Element*>& elements);
+
+    /// \brief The slot flags.
+    enum Flags: uint8_t
+    {
+        /// \brief The Element is hidden.
+        HIDDEN = 1 << 0,
+        /// \brief The Element is disabled.
+        DISABLED = 1 << 1
+    };
+
+private:
+    /// \brief Rebuild all slots from the Element tree.
+    void _rebuild();
+
+    /// \brief Rebuild if needed and update the derived arrays if needed.
+    void _validate();
+
+    /// \brief Recompute screen positions and total shapes.
+    void _derive();
+
+    /// \brief Find the front-most Element in a slot's subtree.
+    /// \param slot The slot to test.
+    /// \param x The screen x coordinate.
+    /// \param y The screen y coordinate.
+    /// \returns the target Element or nullptr if none.
+    Element* _hitTest(std::size_t slot, float x, float y) const;
+
+    /// \brief The root Element.
+    Element* _root = nullptr;
+
+    /// \brief True if the slots must be rebuilt before the next query.
+    bool _invalid = true;
+
+    /// \brief True if the derived arrays must be recomputed.
+    bool _derivedInvalid = true;
+
+    /// \brief The Element in each slot.
+    std::vector<Element*> _elements;
+
+    /// \brief The parent slot of each slot. The root is its own parent.
+    std::vector<uint32_t> _parents;
+
+    /// \brief The first child slot of each slot.
+    std::vector<uint32_t> _firstChildren;
+
+    /// \brief The number of children of each slot.
+    std::vector<uint32_t> _numChildren;
+
+    /// \brief The x position of each slot in parent coordinates.
+    std::vector<float> _x;
+
+    /// \brief The y position of each slot in parent coordinates.
+    std::vector<float> _y;
+
+    /// \brief The width of each slot.
+    std::vector<float> _width;
+
+    /// \brief The height of each slot.
+    std::vector<float> _height;
+
+    /// \brief The Flags of each slot.
+    std::vector<uint8_t> _flags;
+
+    /// \brief The Flags of each slot combined with those of its ancestors.
+    std::vector<uint8_t> _effectiveFlags;
+
+    /// \brief The x position of each slot in screen coordinates.
+    std::vector<float> _screenX;
+
+    /// \brief The y position of each slot in screen coordinates.
+    std::vector<float> _screenY;
+
+    /// \brief The left edge of each slot's total shape in screen coordinates.
+    std::vector<float> _totalLeft;
+
+    /// \brief The top edge of each slot's total shape in screen coordinates.
+    std::vector<float> _totalTop;
+
+    /// \brief The right edge of each slot's total shape in screen coordinates.
+    std::vector<float> _totalRight;
+
+    /// \brief The bottom edge of each slot's total shape in screen coordinates.
+    std::vector<float> _totalBottom;
+
+};
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include "ofEvents.h"
+#include "ofx/PointerEvents.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief Serializes the input events reaching a Document to a binary stream.
+///
+/// Each record stores the time since the recorder was created and every
+/// field of the event, including the full Point and any coalesced and
+/// predicted events, so that a replay reproduces the event exactly. Event
+/// type and device type strings are written once and referred to by index
+/// afterwards, so a typical pointer record is about 130 bytes.
+///
+/// Multi-byte values are written in little-endian byte order and floats as
+/// their IEEE 754 bits, so a recording made on one platform can be replayed
+/// with InputReplay on any other.
+///
+/// To record a Document, call Document::setInputRecorder(). The recorder must
+/// outlive its use by the Document.
+class InputRecorder
+{
+public:
+    /// \brief Create an InputRecorder that writes to a stream.
+    ///
+    /// The stream header is written immediately.
+    ///
+    /// \param stream The binary output stream. It must outlive the recorder.
+    InputRecorder(std::ostream& stream);
+
+    /// \brief Destroy the InputRecorder.
+    ~InputRecorder();
+
+    /// \brief Record a pointer event.
+    /// \param e The pointer event to record.
+    void record(const PointerEventArgs& e);
+
+    /// \brief Record a key event.
+    /// \param e The key event to record.
+    void record(const ofKeyEventArgs& e);
+
+    /// \returns the number of events recorded.
+    std::size_t numRecords() const;
+
+    /// \brief The kind of a record in the stream.
+    enum RecordType: uint8_t
+    {
+        /// \brief A PointerEventArgs record.
+        POINTER_RECORD = 0,
+        /// \brief An ofKeyEventArgs record.
+        KEY_RECORD = 1
+    };
+
+    /// \brief The boolean fields of a pointer record.
+    enum PointerFlags: uint8_t
+    {
+        /// \brief PointerEventArgs::canHover() is true.
+        CAN_HOVER = 1 << 0,
+        /// \brief PointerEventArgs::isCoalesced() is true.
+        IS_COALESCED = 1 << 1,
+        /// \brief PointerEventArgs::isPredicted() is true.
+        IS_PREDICTED = 1 << 2,
+        /// \brief PointerEventArgs::isPrimary() is true.
+        IS_PRIMARY = 1 << 3
+    };
+
+    /// \brief The identifier at the beginning of every stream.
+    static const uint32_t MAGIC;
+
+    /// \brief The version of the stream format.
+    static const uint32_t VERSION;
+
+private:
+    /// \brief Write the record type and time.
+    /// \param type The kind of record.
+    void _writeRecordHeader(RecordType type);
+
+    /// \brief Write the fields of a pointer event.
+    ///
+    /// Coalesced and predicted events are written recursively.
+    ///
+    /// \param e The pointer event to write.
+    void _writePointer(const PointerEventArgs& e);
+
+    /// \brief Write a string, adding it to the string table if needed.
+    /// \param value The string to write.
+    void _writeString(const std::string& value);
+
+    /// \brief The output stream.
+    std::ostream& _stream;
+
+    /// \brief The time the recorder was created.
+    std::chrono::steady_clock::time_point _start;
+
+    /// \brief The number of events recorded.
+    std::size_t _numRecords = 0;
+
+    /// \brief The indices of strings that have been written.
+    std::unordered_map<std::string, uint32_t> _strings;
+
+};
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,135 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "ofx/DOM/EventQueue.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+class Document;
+
+
+/// \brief Replays a stream written by InputRecorder into a Document.
+///
+/// The replay does not require a window or a running app. Events are passed
+/// to Document::onPointerEvent() and Document::onKeyEvent() and
+/// Document::update() is called once per frame of recorded time, so queued
+/// and coalesced events are dispatched as they would be in the app.
+class InputReplay
+{
+public:
+    /// \brief The replay timing.
+    enum class Mode
+    {
+        /// \brief Replay events as fast as possible.
+        FULL_SPEED,
+        /// \brief Replay events at their recorded times.
+        REAL_TIME
+    };
+
+    /// \brief A summary of a set of durations.
+    struct Percentiles
+    {
+        /// \brief The median duration in nanoseconds.
+        uint64_t p50 = 0;
+
+        /// \brief The 90th percentile duration in nanoseconds.
+        uint64_t p90 = 0;
+
+        /// \brief The 99th percentile duration in nanoseconds.
+        uint64_t p99 = 0;
+
+        /// \brief The maximum duration in nanoseconds.
+        uint64_t max = 0;
+    };
+
+    /// \brief The measurements from a single replay.
+    struct Results
+    {
+        /// \brief The number of events replayed.
+        std::size_t numEvents = 0;
+
+        /// \brief The number of frames updated.
+        std::size_t numFrames = 0;
+
+        /// \brief The total replay time in microseconds.
+        uint64_t durationMicros = 0;
+
+        /// \brief The number of events replayed per second.
+        double eventsPerSecond = 0;
+
+        /// \brief The time to handle each event.
+        Percentiles eventLatency;
+
+        /// \brief The time to update each frame, including queued events.
+        Percentiles frameLatency;
+
+        /// \returns a human readable summary.
+        std::string toString() const;
+    };
+
+    /// \brief Create an empty InputReplay.
+    InputReplay();
+
+    /// \brief Destroy the InputReplay.
+    ~InputReplay();
+
+    /// \brief Read all records from a stream written by InputRecorder.
+    /// \param stream The binary input stream.
+    /// \throws DOMException if the stream is not a valid recording.
+    void load(std::istream& stream);
+
+    /// \returns the number of loaded records.
+    std::size_t size() const;
+
+    /// \returns the recorded duration in microseconds.
+    uint64_t durationMicros() const;
+
+    /// \brief Replay the loaded records into a Document.
+    /// \param document The Document to receive the events.
+    /// \param mode The replay timing.
+    /// \param frameIntervalMicros The recorded time between updates.
+    /// \returns the measurements.
+    Results run(Document& document,
+                Mode mode = Mode::FULL_SPEED,
+                uint64_t frameIntervalMicros = DEFAULT_FRAME_INTERVAL_MICROS);
+
+    /// \brief The default time between updates, about 60 frames per second.
+    static const uint64_t DEFAULT_FRAME_INTERVAL_MICROS;
+
+private:
+    /// \brief A single loaded event.
+    struct Record
+    {
+        /// \brief The recorded time in microseconds.
+        uint64_t timeMicros = 0;
+
+        /// \brief The event data.
+        EventQueue::Entry entry;
+    };
+
+    /// \brief Summarize a list of durations.
+    /// \param durations The durations in nanoseconds, sorted in place.
+    /// \returns the percentiles.
+    static Percentiles _percentiles(std::vector<uint64_t>& durations);
+
+    /// \brief The loaded records in recorded order.
+    std::vector<Record> _records;
+
+};
+
+
+} } // namespace ofx::DOM
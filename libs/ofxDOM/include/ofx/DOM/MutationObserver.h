@@ -0,0 +1,206 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+namespace ofx {
+namespace DOM {
+
+
+class Document;
+class Element;
+
+
+/// \brief A record of a single change to the Document tree.
+///
+/// When an Element leaves the Document, pending records targeting it or its
+/// descendants are discarded, so target() is valid while a record is being
+/// delivered. The added, removed and reordered Elements are not tracked and
+/// should only be compared, not dereferenced.
+///
+/// \sa https://dom.spec.whatwg.org/#mutationrecord
+class MutationRecord
+{
+public:
+    /// \brief The kind of change.
+    enum class Type
+    {
+        /// \brief Children were added to or removed from the target.
+        CHILD_LIST,
+        /// \brief A child of the target changed its position.
+        CHILD_ORDER,
+        /// \brief An attribute of the target was set or cleared.
+        ATTRIBUTES
+    };
+
+    /// \brief Create a MutationRecord.
+    /// \param type The kind of change.
+    /// \param target The Element that changed.
+    MutationRecord(Type type, Element* target);
+
+    /// \brief Destroy the MutationRecord.
+    ~MutationRecord();
+
+    /// \returns the kind of change.
+    Type type() const;
+
+    /// \returns the Element that changed, which is still in the Document.
+    Element* target() const;
+
+    /// \brief Get the added children for Type::CHILD_LIST records.
+    ///
+    /// Added Elements may have been removed and destroyed by the time the
+    /// record is delivered, so they should only be compared, not
+    /// dereferenced.
+    ///
+    /// \returns the added children.
+    const std::vector<Element*>& addedElements() const;
+
+    /// \brief Get the removed children for Type::CHILD_LIST records.
+    ///
+    /// Removed Elements may have been destroyed by the time the record is
+    /// delivered, so they should only be compared, not dereferenced.
+    ///
+    /// \returns the removed children.
+    const std::vector<Element*>& removedElements() const;
+
+    /// \returns the reordered child for Type::CHILD_ORDER records.
+    Element* reorderedElement() const;
+
+    /// \returns the old child index for Type::CHILD_ORDER records.
+    std::size_t oldIndex() const;
+
+    /// \returns the new child index for Type::CHILD_ORDER records.
+    std::size_t newIndex() const;
+
+    /// \returns the attribute name for Type::ATTRIBUTES records.
+    const std::string& attributeName() const;
+
+private:
+    /// \brief The kind of change.
+    Type _type = Type::CHILD_LIST;
+
+    /// \brief The Element that changed.
+    Element* _target = nullptr;
+
+    /// \brief The added children.
+    std::vector<Element*> _addedElements;
+
+    /// \brief The removed children.
+    std::vector<Element*> _removedElements;
+
+    /// \brief The reordered child.
+    Element* _reorderedElement = nullptr;
+
+    /// \brief The old child index.
+    std::size_t _oldIndex = 0;
+
+    /// \brief The new child index.
+    std::size_t _newIndex = 0;
+
+    /// \brief The attribute name.
+    std::string _attributeName;
+
+    /// \brief The Element class fills in the record.
+    friend class Element;
+
+};
+
+
+/// \brief The changes that a MutationObserver observes.
+///
+/// \sa https://dom.spec.whatwg.org/#dictdef-mutationobserverinit
+struct MutationObserverInit
+{
+    /// \brief True to observe children being added or removed.
+    bool childList = true;
+
+    /// \brief True to observe children being reordered.
+    bool childOrder = true;
+
+    /// \brief True to observe attributes being set or cleared.
+    bool attributes = true;
+
+    /// \brief True to observe all descendants of the target as well.
+    bool subtree = false;
+};
+
+
+/// \brief Receives batches of MutationRecords once per frame.
+///
+/// Records are collected as the Document tree changes and delivered together
+/// during Document::update(), so an observer does work proportional to the
+/// number of changes once per frame rather than once per change.
+///
+/// \sa https://dom.spec.whatwg.org/#mutationobserver
+class MutationObserver
+{
+public:
+    /// \brief The callback receiving the records.
+    typedef std::function<void(const std::vector<MutationRecord>&, MutationObserver&)> Callback;
+
+    /// \brief Create a MutationObserver.
+    /// \param callback The callback receiving the records.
+    MutationObserver(Callback callback);
+
+    /// \brief Destroy the MutationObserver, disconnecting it.
+    ~MutationObserver();
+
+    MutationObserver(const MutationObserver&) = delete;
+    MutationObserver& operator = (const MutationObserver&) = delete;
+
+    /// \brief Observe changes to an Element.
+    ///
+    /// Observing a target again replaces its options. All targets must belong
+    /// to the same Document. A target is no longer observed once it leaves
+    /// the Document.
+    ///
+    /// \param target The Element to observe.
+    /// \param options The changes to observe.
+    /// \throws DOMException if the target is not in a Document or is in a
+    /// different Document than the other targets.
+    void observe(Element* target, const MutationObserverInit& options = MutationObserverInit());
+
+    /// \brief Stop observing all targets and discard any pending records.
+    void disconnect();
+
+    /// \brief Remove and return the pending records.
+    /// \returns the pending records.
+    std::vector<MutationRecord> takeRecords();
+
+private:
+    /// \brief Determine if a record matches any of the observed targets.
+    /// \param record The record to test.
+    /// \returns true if the record should be delivered to this observer.
+    bool matches(const MutationRecord& record) const;
+
+    /// \brief The callback receiving the records.
+    Callback _callback;
+
+    /// \brief The Document of the observed targets or nullptr if none.
+    Document* _document = nullptr;
+
+    /// \brief The observed targets and their options.
+    std::vector<std::pair<Element*, MutationObserverInit>> _targets;
+
+    /// \brief The records waiting for delivery.
+    std::vector<MutationRecord> _records;
+
+    /// \brief The Document class queues and delivers records.
+    friend class Document;
+
+};
+
+
+} } // namespace ofx::DOM
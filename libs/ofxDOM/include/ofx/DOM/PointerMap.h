@@ -0,0 +1,172 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief A small map from pointer ids to values.
+///
+/// Only a handful of pointers are active at once, so the entries are kept in
+/// a flat vector and found with a linear scan. Erased entries are kept as
+/// spares and reused by later pointer ids, so once the map has held as many
+/// pointers as are used at once, adding a pointer does not allocate.
+///
+/// The interface is the subset of std::unordered_map used by Document.
+/// Iterators are invalidated by any insertion or erasure.
+///
+/// \tparam ValueType The type of the mapped values.
+template <typename ValueType>
+class PointerMap
+{
+public:
+    typedef std::pair<std::size_t, ValueType> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    /// \returns an iterator to the first entry.
+    iterator begin()
+    {
+        return _entries.begin();
+    }
+
+    /// \returns an iterator past the last entry.
+    iterator end()
+    {
+        return _entries.begin() + _size;
+    }
+
+    /// \returns an iterator to the first entry.
+    const_iterator begin() const
+    {
+        return _entries.begin();
+    }
+
+    /// \returns an iterator past the last entry.
+    const_iterator end() const
+    {
+        return _entries.begin() + _size;
+    }
+
+    /// \returns the number of entries.
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    /// \returns true if there are no entries.
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+    /// \brief Find the entry for a pointer id.
+    /// \param id The pointer id.
+    /// \returns an iterator to the entry or end() if none.
+    iterator find(std::size_t id)
+    {
+        iterator iter = begin();
+
+        while (iter != end() && iter->first != id)
+        {
+            ++iter;
+        }
+
+        return iter;
+    }
+
+    /// \brief Find the entry for a pointer id.
+    /// \param id The pointer id.
+    /// \returns an iterator to the entry or end() if none.
+    const_iterator find(std::size_t id) const
+    {
+        const_iterator iter = begin();
+
+        while (iter != end() && iter->first != id)
+        {
+            ++iter;
+        }
+
+        return iter;
+    }
+
+    /// \brief Get the value for a pointer id, adding an entry if needed.
+    ///
+    /// A new entry reuses a spare entry when one is available. A reused value
+    /// keeps its previous contents until it is assigned.
+    ///
+    /// \param id The pointer id.
+    /// \returns the value for the pointer id.
+    ValueType& operator [] (std::size_t id)
+    {
+        iterator iter = find(id);
+
+        if (iter != end())
+        {
+            return iter->second;
+        }
+
+        if (_size == _entries.size())
+        {
+            _entries.emplace_back(id, ValueType());
+        }
+        else
+        {
+            _entries[_size].first = id;
+        }
+
+        return _entries[_size++].second;
+    }
+
+    /// \brief Erase an entry, keeping its storage as a spare.
+    /// \param iter An iterator to the entry to erase.
+    void erase(iterator iter)
+    {
+        // The order of entries is not significant.
+        if (iter != end() - 1)
+        {
+            std::swap(*iter, _entries[_size - 1]);
+        }
+
+        --_size;
+    }
+
+    /// \brief Erase the entry for a pointer id, if any.
+    /// \param id The pointer id.
+    /// \returns the number of erased entries.
+    std::size_t erase(std::size_t id)
+    {
+        iterator iter = find(id);
+
+        if (iter == end())
+        {
+            return 0;
+        }
+
+        erase(iter);
+        return 1;
+    }
+
+private:
+    /// \brief The entries followed by the spare entries.
+    std::vector<value_type> _entries;
+
+    /// \brief The number of entries in use.
+    std::size_t _size = 0;
+
+};
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <string>
+#include <vector>
+#include "ofx/DOM/AttributeStore.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief A compiled selector used by Element::querySelector().
+///
+/// The supported syntax is a subset of CSS selectors:
+///
+/// - `tag` matches Elements of a type registered with
+///   Document::registerTypeTag().
+/// - `*` matches any Element.
+/// - `#id` matches Elements with the given id.
+/// - `[name]` matches Elements with the given attribute.
+/// - `[name=value]` matches Elements whose attribute is a std::string or
+///   const char* equal to value. The value may be quoted.
+/// - `a b` matches b when it is a descendant of a.
+/// - `a > b` matches b when it is a child of a.
+/// - `a, b` matches either a or b.
+///
+/// Names and unquoted values may contain letters, digits, '-' and '_'.
+///
+/// Generally this class should not be instantiated directly, since
+/// Document caches the compiled selectors.
+class Selector
+{
+public:
+    /// \brief A test of a single attribute.
+    struct Attribute
+    {
+        /// \brief The attribute name.
+        std::string name;
+
+        /// \brief The interned attribute name or nullptr if the name is not
+        /// registered, in which case no Element has the attribute.
+        AttributeKey key = nullptr;
+
+        /// \brief True if the attribute value must equal value.
+        bool hasValue = false;
+
+        /// \brief The value to compare with.
+        std::string value;
+    };
+
+    /// \brief A sequence of tests that all apply to a single Element.
+    struct Compound
+    {
+        /// \brief The registered type tag or empty for any type.
+        std::string typeTag;
+
+        /// \brief The id or empty for any id.
+        std::string id;
+
+        /// \brief The attribute tests.
+        std::vector<Attribute> attributes;
+    };
+
+    /// \brief The relationship between two consecutive Compounds.
+    enum class Combinator
+    {
+        /// \brief The right Compound is a descendant of the left.
+        DESCENDANT,
+        /// \brief The right Compound is a child of the left.
+        CHILD
+    };
+
+    /// \brief A chain of Compounds joined by Combinators.
+    struct Complex
+    {
+        /// \brief The Compounds from the outermost to the subject.
+        std::vector<Compound> compounds;
+
+        /// \brief The Combinator following each Compound but the last.
+        std::vector<Combinator> combinators;
+    };
+
+    /// \brief Compile a selector.
+    /// \param selector The selector text.
+    /// \throws DOMException if the selector is not valid.
+    Selector(const std::string& selector);
+
+    /// \brief Destroy the Selector.
+    ~Selector();
+
+    /// \returns the selector text.
+    const std::string& source() const;
+
+    /// \returns the alternatives separated by commas.
+    const std::vector<Complex>& alternatives() const;
+
+    /// \brief Look up the keys of attribute names registered since the
+    /// selector was compiled.
+    ///
+    /// Compiling does not register attribute names, so a cached selector
+    /// must resolve its keys before matching. This does nothing once every
+    /// key is resolved.
+    void resolveKeys();
+
+private:
+    /// \brief Parse a Compound at the cursor.
+    /// \returns the Compound.
+    /// \throws DOMException if no valid Compound is found.
+    Compound _parseCompound();
+
+    /// \brief Parse a name at the cursor.
+    /// \returns the name.
+    /// \throws DOMException if no name is found.
+    std::string _parseName();
+
+    /// \brief Parse a quoted or unquoted attribute value at the cursor.
+    /// \returns the value.
+    /// \throws DOMException if no value is found.
+    std::string _parseValue();
+
+    /// \brief Skip whitespace at the cursor.
+    /// \returns true if any whitespace was skipped.
+    bool _skipWhitespace();
+
+    /// \brief Throw a DOMException describing a syntax error at the cursor.
+    /// \param message The description of the error.
+    [[noreturn]] void _error(const std::string& message) const;
+
+    /// \brief The selector text.
+    std::string _source;
+
+    /// \brief The parse position in the selector text.
+    std::size_t _cursor = 0;
+
+    /// \brief The alternatives separated by commas.
+    std::vector<Complex> _alternatives;
+
+    /// \brief The number of attribute tests without a key.
+    std::size_t _numUnresolvedKeys = 0;
+
+};
+
+
+} } // namespace ofx::DOM
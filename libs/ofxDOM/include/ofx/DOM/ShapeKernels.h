@@ -0,0 +1,77 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <cstddef>
+
+
+namespace ofx {
+namespace DOM {
+
+
+/// \brief Bulk operations on packed arrays of rectangles.
+///
+/// Rectangles are given as four parallel arrays of edges. The kernels use AVX
+/// or SSE2 when the compiler targets them and a scalar loop otherwise, with
+/// identical results.
+class ShapeKernels
+{
+public:
+    /// \brief Find the first rectangle strictly containing a point.
+    ///
+    /// Containment matches Shape::inside(), so points on an edge are outside.
+    ///
+    /// \param left The left edges.
+    /// \param top The top edges.
+    /// \param right The right edges.
+    /// \param bottom The bottom edges.
+    /// \param first The index to start searching from.
+    /// \param last The index to stop searching at, exclusive.
+    /// \param x The x coordinate of the point.
+    /// \param y The y coordinate of the point.
+    /// \returns the index of the first containing rectangle in [first, last)
+    /// or last if none contain the point.
+    static std::size_t findContaining(const float* left,
+                                      const float* top,
+                                      const float* right,
+                                      const float* bottom,
+                                      std::size_t first,
+                                      std::size_t last,
+                                      float x,
+                                      float y);
+
+    /// \brief Grow a bounding rectangle to include many rectangles.
+    /// \param left The left edges.
+    /// \param top The top edges.
+    /// \param right The right edges.
+    /// \param bottom The bottom edges.
+    /// \param first The index of the first rectangle to include.
+    /// \param last The index to stop at, exclusive.
+    /// \param boundsLeft The left edge of the bounds to grow.
+    /// \param boundsTop The top edge of the bounds to grow.
+    /// \param boundsRight The right edge of the bounds to grow.
+    /// \param boundsBottom The bottom edge of the bounds to grow.
+    static void growToInclude(const float* left,
+                              const float* top,
+                              const float* right,
+                              const float* bottom,
+                              std::size_t first,
+                              std::size_t last,
+                              float& boundsLeft,
+                              float& boundsTop,
+                              float& boundsRight,
+                              float& boundsBottom);
+
+    /// \returns the name of the instruction set used by the kernels.
+    static const char* instructionSet();
+
+};
+
+
+} } // namespace ofx::DOM
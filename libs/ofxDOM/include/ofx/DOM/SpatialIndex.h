@@ -0,0 +1,165 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#pragma once
+
+
+#include <vector>
+#include "ofx/DOM/Types.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+class Element;
+
+
+/// \brief A uniform grid used to accelerate hit testing of child Elements.
+///
+/// The grid indexes the total shape of each child in the parent's local
+/// coordinates. Each cell keeps its child indices sorted in the same order as
+/// the parent's children (front to back), so iterating over the cell for a
+/// given position preserves the z-order semantics of a linear search.
+///
+/// Children being added or removed requires a full rebuild, which is done
+/// lazily on the next query. Reordering children renumbers only the children
+/// between the old and new index. Changes to the shape of a single child are
+/// applied incrementally on the next query.
+///
+/// Generally this class should not be instantiated directly but instead
+/// should be enabled using Element::setSpatialIndexEnabled(true).
+class SpatialIndex
+{
+public:
+    /// \brief Create a SpatialIndex for the given Element parent.
+    /// \param parent The Element whose children will be indexed.
+    /// \param elementsPerCell The target number of children per grid cell.
+    SpatialIndex(Element* parent,
+                 std::size_t elementsPerCell = DEFAULT_ELEMENTS_PER_CELL);
+
+    /// \brief Destroy the SpatialIndex.
+    ~SpatialIndex();
+
+    /// \returns a pointer to the parent Element or nullptr if none.
+    Element* parent();
+
+    /// \brief Mark the whole index as invalid.
+    ///
+    /// This must be called when children are added or removed.
+    void invalidate();
+
+    /// \brief Mark the indexed shape of a single child as invalid.
+    /// \param child The child whose total shape has changed.
+    void invalidate(const Element* child);
+
+    /// \brief Move the indexed child at one index to another.
+    ///
+    /// This must be called when a child is reordered. The children between
+    /// the two indices shift by one place toward the old index.
+    ///
+    /// \param oldIndex The child's previous index.
+    /// \param newIndex The child's new index.
+    void moveChild(std::size_t oldIndex, std::size_t newIndex);
+
+    /// \returns true iff the index does not require a full rebuild.
+    bool isValid() const;
+
+    /// \brief Find the children whose total shape may contain a position.
+    ///
+    /// The returned indices refer to the parent's children and are sorted
+    /// front to back. The reference is valid until the next call to query().
+    ///
+    /// \param localPosition The position to query in parent local coordinates.
+    /// \returns the candidate child indices.
+    const std::vector<std::size_t>& query(const Position& localPosition);
+
+    /// \brief The default target number of children per grid cell.
+    static const std::size_t DEFAULT_ELEMENTS_PER_CELL;
+
+    /// \brief The maximum number of columns or rows in the grid.
+    static const std::size_t MAX_CELLS_PER_AXIS;
+
+private:
+    /// \brief Rebuild the whole grid from the parent's children.
+    void _rebuild();
+
+    /// \brief Reindex the shapes of the children marked as stale.
+    void _updateStale();
+
+    /// \brief Add the child at the given index to all overlapping cells.
+    /// \param index The child index.
+    void _insert(std::size_t index);
+
+    /// \brief Remove the child at the given index from all overlapping cells.
+    /// \param index The child index.
+    void _remove(std::size_t index);
+
+    /// \brief Change the index of a child in all overlapping cells.
+    ///
+    /// No other child may be indexed between the two indices in those cells.
+    ///
+    /// \param oldIndex The child's previous index.
+    /// \param newIndex The child's new index.
+    void _renumber(std::size_t oldIndex, std::size_t newIndex);
+
+    /// \brief Calculate the range of cells overlapped by a shape.
+    void _cellRange(const Shape& shape,
+                    std::size_t& column0,
+                    std::size_t& row0,
+                    std::size_t& column1,
+                    std::size_t& row1) const;
+
+    /// \returns the clamped column containing the given x coordinate.
+    std::size_t _column(float x) const;
+
+    /// \returns the clamped row containing the given y coordinate.
+    std::size_t _row(float y) const;
+
+    /// \brief The owning Element.
+    Element* _parent = nullptr;
+
+    /// \brief The target number of children per grid cell.
+    std::size_t _elementsPerCell = DEFAULT_ELEMENTS_PER_CELL;
+
+    /// \brief True if the grid must be rebuilt before the next query.
+    bool _invalid = true;
+
+    /// \brief The bounds of all indexed shapes when the grid was built.
+    Shape _bounds;
+
+    /// \brief The number of grid columns.
+    std::size_t _columns = 0;
+
+    /// \brief The number of grid rows.
+    std::size_t _rows = 0;
+
+    /// \brief The width of a single grid cell.
+    float _cellWidth = 1;
+
+    /// \brief The height of a single grid cell.
+    float _cellHeight = 1;
+
+    /// \brief The sorted child indices for each cell, row major.
+    std::vector<std::vector<std::size_t>> _cells;
+
+    /// \brief The indexed total shape of each child.
+    std::vector<Shape> _shapes;
+
+    /// \brief True for each child whose indexed shape is out of date.
+    std::vector<bool> _isStale;
+
+    /// \brief The indices of children whose indexed shape is out of date.
+    std::vector<std::size_t> _stale;
+
+    /// \brief An empty result returned when there is nothing to query.
+    std::vector<std::size_t> _empty;
+
+};
+
+
+} } // namespace ofx::DOM
@@ -13,6 +13,7 @@
 #include <typeinfo>
 #include <string>
 #include <cassert>
+#include <new>
 #include "ofRectangle.h"
 #include "ofTypes.h"
 
@@ -52,128 +53,197 @@ template <class T>
 using StorageType = typename std::decay<T>::type;
 
 /// \brief C++11 Any class.
+///
+/// Trivially copyable values that fit in BUFFER_SIZE bytes, such as numbers,
+/// colors and glm vectors, are stored inline without an allocation. Other
+/// values are stored on the heap. Type checks compare a per-type operations
+/// table first and only compare type_info when the tables differ.
+///
 /// \sa https://codereview.stackexchange.com/questions/20058/c11-any-class
 /// \note This class may change in the near future.
 struct Any
 {
-    bool is_null() const { return !ptr; }
-    bool not_null() const { return ptr; }
+    /// \brief The number of bytes available for inline values.
+    enum
+    {
+        BUFFER_SIZE = 16
+    };
+
+    bool is_null() const { return !_operations; }
+    bool not_null() const { return _operations; }
 
-    template <typename U> Any(U&& value)
-    : ptr(new Derived<StorageType<U>>(std::forward<U>(value)))
+    template <typename U,
+              typename = typename std::enable_if<!std::is_same<StorageType<U>, Any>::value>::type>
+    Any(U&& value): _operations(&Model<StorageType<U>>::operations)
     {
+        _construct<StorageType<U>>(std::forward<U>(value), IsInline<StorageType<U>>());
     }
 
     template <class U> bool is() const
     {
-        typedef StorageType<U> T;
-
-        auto derived = dynamic_cast<Derived<T>*>(ptr);
-
-        return derived;
+        // A shared library may have its own copy of a type's table, so fall
+        // back to comparing type_info when the addresses differ.
+        return _operations == &Model<StorageType<U>>::operations
+            || (_operations && *_operations->type == typeid(StorageType<U>));
     }
 
     template <class U>
     StorageType<U>& as()
     {
-        typedef StorageType<U> T;
-
-        auto derived = dynamic_cast<Derived<T>*>(ptr);
-
-        if (!derived)
+        if (!is<U>())
             throw std::bad_cast();
 
-        return derived->value;
+        return *static_cast<StorageType<U>*>(_value<StorageType<U>>());
     }
 
     template <class U>
-    operator U()
+    const StorageType<U>& as() const
     {
-        return as<StorageType<U>>();
-    }
+        if (!is<U>())
+            throw std::bad_cast();
 
-    Any(): ptr(nullptr)
-    {
+        return *static_cast<const StorageType<U>*>(const_cast<Any*>(this)->_value<StorageType<U>>());
     }
 
-    Any(Any& that): ptr(that.clone())
+    template <class U>
+    operator U() const
     {
-
+        return as<StorageType<U>>();
     }
 
-    Any(Any&& that): ptr(that.ptr)
+    Any(): _operations(nullptr)
     {
-        that.ptr = nullptr;
     }
 
-    Any(const Any& that): ptr(that.clone())
+    Any(const Any& that): _operations(nullptr)
     {
-    }
+        if (that._operations && that._operations->clone)
+            that._operations->clone(that._storage, _storage);
+        else
+            _storage = that._storage;
 
+        _operations = that._operations;
+    }
 
-    Any(const Any&& that): ptr(that.clone())
+    Any(Any&& that) noexcept: _storage(that._storage), _operations(that._operations)
     {
+        that._operations = nullptr;
     }
 
-
-    Any& operator=(const Any& a)
+    Any& operator=(const Any& that)
     {
-        if (ptr == a.ptr)
-            return *this;
-
-        auto old_ptr = ptr;
-
-        ptr = a.clone();
-
-        if (old_ptr)
-            delete old_ptr;
+        if (this != &that)
+        {
+            // Copy first so that a throwing copy leaves this value unchanged.
+            Any copy(that);
+            *this = std::move(copy);
+        }
 
         return *this;
     }
 
-    Any& operator=(Any&& a)
+    Any& operator=(Any&& that) noexcept
     {
-        if (ptr == a.ptr)
-            return *this;
-
-        std::swap(ptr, a.ptr);
+        if (this != &that)
+        {
+            _destroy();
+            _storage = that._storage;
+            _operations = that._operations;
+            that._operations = nullptr;
+        }
 
         return *this;
     }
 
     ~Any()
     {
-        if (ptr)
-            delete ptr;
+        _destroy();
     }
 
 private:
-    struct Base
+    /// \brief The inline buffer or a pointer to a heap allocated value.
+    union Storage
     {
-        virtual ~Base() {}
+        void* pointer;
+        double alignment;
+        unsigned char buffer[BUFFER_SIZE];
+    };
 
-        virtual Base* clone() const = 0;
+    /// \brief The operations needed for a heap allocated value.
+    ///
+    /// Inline values are copied, moved and destroyed bitwise, so their
+    /// operations are null. The address of a type's table identifies it
+    /// within one module, and its type_info identifies it across modules.
+    /// The type_info also keeps the tables distinct so that a linker folding
+    /// identical constants (e.g. MSVC /OPT:ICF) cannot merge the tables of
+    /// two inline types.
+    struct Operations
+    {
+        const std::type_info* type;
+        void (*clone)(const Storage& from, Storage& to);
+        void (*destroy)(Storage& storage);
     };
 
     template <typename T>
-    struct Derived: Base
+    using IsInline = std::integral_constant<bool,
+                                            std::is_trivially_copyable<T>::value
+                                         && sizeof(T) <= BUFFER_SIZE
+                                         && alignof(T) <= alignof(Storage)>;
+
+    template <typename T>
+    struct Model
     {
-        template <typename U> Derived(U&& value) : value(std::forward<U>(value)) { }
+        static void clone(const Storage& from, Storage& to)
+        {
+            to.pointer = new T(*static_cast<const T*>(from.pointer));
+        }
 
-        T value;
+        static void destroy(Storage& storage)
+        {
+            delete static_cast<T*>(storage.pointer);
+        }
 
-        Base* clone() const { return new Derived<T>(value); }
+        static const Operations operations;
     };
 
-    Base* clone() const
+    template <typename T, typename U>
+    void _construct(U&& value, std::true_type)
     {
-        if (ptr)
-            return ptr->clone();
-        else
-            return nullptr;
+        new (_storage.buffer) T(std::forward<U>(value));
     }
 
-    Base* ptr;
+    template <typename T, typename U>
+    void _construct(U&& value, std::false_type)
+    {
+        _storage.pointer = new T(std::forward<U>(value));
+    }
+
+    template <typename T>
+    void* _value()
+    {
+        return IsInline<T>::value ? static_cast<void*>(_storage.buffer) : _storage.pointer;
+    }
+
+    void _destroy()
+    {
+        if (_operations && _operations->destroy)
+            _operations->destroy(_storage);
+
+        _operations = nullptr;
+    }
+
+    Storage _storage;
+
+    const Operations* _operations;
+};
+
+
+template <typename T>
+const Any::Operations Any::Model<T>::operations =
+{
+    &typeid(T),
+    Any::IsInline<T>::value ? nullptr : &Any::Model<T>::clone,
+    Any::IsInline<T>::value ? nullptr : &Any::Model<T>::destroy
 };
 
 
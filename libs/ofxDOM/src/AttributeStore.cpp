@@ -0,0 +1,242 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/AttributeStore.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+AttributeKey AttributeKeyRegistry::keyForName(const std::string& name)
+{
+    AttributeKeyRegistry& registry = instance();
+
+    std::unique_lock<std::mutex> lock(registry._mutex);
+
+    return &*registry._names.insert(name).first;
+}
+
+
+AttributeKey AttributeKeyRegistry::findKey(const std::string& name)
+{
+    AttributeKeyRegistry& registry = instance();
+
+    std::unique_lock<std::mutex> lock(registry._mutex);
+
+    auto iter = registry._names.find(name);
+
+    return iter != registry._names.end() ? &*iter : nullptr;
+}
+
+
+std::size_t AttributeKeyRegistry::size()
+{
+    AttributeKeyRegistry& registry = instance();
+
+    std::unique_lock<std::mutex> lock(registry._mutex);
+
+    return registry._names.size();
+}
+
+
+AttributeKeyRegistry::AttributeKeyRegistry()
+{
+}
+
+
+AttributeKeyRegistry& AttributeKeyRegistry::instance()
+{
+    static AttributeKeyRegistry* registry = new AttributeKeyRegistry();
+    return *registry;
+}
+
+
+AttributeStore::AttributeStore()
+{
+}
+
+
+AttributeStore::~AttributeStore()
+{
+}
+
+
+std::size_t AttributeStore::size() const
+{
+    return _entries.size();
+}
+
+
+bool AttributeStore::empty() const
+{
+    return _entries.empty();
+}
+
+
+AttributeStore::const_iterator AttributeStore::begin() const
+{
+    return _entries.begin();
+}
+
+
+AttributeStore::const_iterator AttributeStore::end() const
+{
+    return _entries.end();
+}
+
+
+Any* AttributeStore::find(const std::string& name)
+{
+    std::size_t index = _indexOf(name);
+    return index < _entries.size() ? &_entries[index].value : nullptr;
+}
+
+
+const Any* AttributeStore::find(const std::string& name) const
+{
+    std::size_t index = _indexOf(name);
+    return index < _entries.size() ? &_entries[index].value : nullptr;
+}
+
+
+const Any* AttributeStore::find(AttributeKey key) const
+{
+    std::size_t index = _indexOf(key);
+    return index < _entries.size() ? &_entries[index].value : nullptr;
+}
+
+
+bool AttributeStore::set(const std::string& name, const Any& value)
+{
+    std::size_t index = _indexOf(name);
+
+    if (index < _entries.size())
+    {
+        _entries[index].value = value;
+        return false;
+    }
+
+    AttributeKey key = AttributeKeyRegistry::keyForName(name);
+
+    _entries.push_back({ key, value });
+
+    if (_index)
+    {
+        (*_index)[key] = index;
+    }
+    else if (_entries.size() > MAX_LINEAR_ATTRIBUTES)
+    {
+        _index.reset(new Index());
+
+        for (std::size_t i = 0; i < _entries.size(); ++i)
+        {
+            (*_index)[_entries[i].key] = i;
+        }
+    }
+
+    return true;
+}
+
+
+bool AttributeStore::erase(const std::string& name)
+{
+    std::size_t index = _indexOf(name);
+
+    if (index == _entries.size())
+    {
+        return false;
+    }
+
+    if (_index)
+    {
+        _index->erase(_entries[index].key);
+    }
+
+    // The order of attributes is not significant, so fill the gap with the
+    // last attribute.
+    if (index + 1 < _entries.size())
+    {
+        _entries[index] = std::move(_entries.back());
+
+        if (_index)
+        {
+            (*_index)[_entries[index].key] = index;
+        }
+    }
+
+    _entries.pop_back();
+
+    // Keep the index until the store is well below the threshold, so that
+    // repeatedly adding and removing one attribute does not rebuild it.
+    if (_index && _entries.size() <= MAX_LINEAR_ATTRIBUTES / 2)
+    {
+        _index.reset();
+    }
+
+    return true;
+}
+
+
+std::size_t AttributeStore::memoryUsage() const
+{
+    std::size_t bytes = sizeof(*this) + _entries.capacity() * sizeof(Entry);
+
+    if (_index)
+    {
+        // Each node holds the value and a next pointer.
+        bytes += sizeof(*_index);
+        bytes += _index->bucket_count() * sizeof(void*);
+        bytes += _index->size() * (sizeof(std::pair<const AttributeKey, std::size_t>) + sizeof(void*));
+    }
+
+    return bytes;
+}
+
+
+std::size_t AttributeStore::_indexOf(const std::string& name) const
+{
+    if (_index)
+    {
+        // The index compares names, so the name can stand in for its key.
+        auto iter = _index->find(&name);
+        return iter != _index->end() ? iter->second : _entries.size();
+    }
+
+    for (std::size_t i = 0; i < _entries.size(); ++i)
+    {
+        if (*_entries[i].key == name)
+        {
+            return i;
+        }
+    }
+
+    return _entries.size();
+}
+
+
+std::size_t AttributeStore::_indexOf(AttributeKey key) const
+{
+    if (_index)
+    {
+        auto iter = _index->find(key);
+        return iter != _index->end() ? iter->second : _entries.size();
+    }
+
+    for (std::size_t i = 0; i < _entries.size(); ++i)
+    {
+        if (_entries[i].key == key)
+        {
+            return i;
+        }
+    }
+
+    return _entries.size();
+}
+
+
+} } // namespace ofx::DOM
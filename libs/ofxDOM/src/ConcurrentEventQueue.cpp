@@ -0,0 +1,151 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/ConcurrentEventQueue.h"
+#include <utility>
+
+
+namespace ofx {
+namespace DOM {
+
+
+ConcurrentEventQueue::ConcurrentEventQueue(): _spares(nullptr)
+{
+    // The queue always contains a stub node, so producers never see an
+    // empty list.
+    Node* stub = new Node();
+    stub->next.store(nullptr, std::memory_order_relaxed);
+    _back.store(stub, std::memory_order_relaxed);
+    _front = stub;
+}
+
+
+ConcurrentEventQueue::~ConcurrentEventQueue()
+{
+    Node* node = _front;
+
+    while (node != nullptr)
+    {
+        Node* next = node->next.load(std::memory_order_acquire);
+        delete node;
+        node = next;
+    }
+
+    node = _spares.load(std::memory_order_acquire);
+
+    while (node != nullptr)
+    {
+        Node* next = node->nextSpare;
+        delete node;
+        node = next;
+    }
+}
+
+
+void ConcurrentEventQueue::push(const PointerEventArgs& e)
+{
+    Node* node = _acquireNode();
+    node->entry.type = EventQueue::Entry::Type::POINTER;
+    node->entry.pointer = e;
+    _push(node);
+}
+
+
+void ConcurrentEventQueue::push(const ofKeyEventArgs& e)
+{
+    Node* node = _acquireNode();
+    node->entry.type = EventQueue::Entry::Type::KEY;
+    node->entry.key = e;
+    _push(node);
+}
+
+
+bool ConcurrentEventQueue::pop(EventQueue::Entry& entry)
+{
+    Node* next = _front->next.load(std::memory_order_acquire);
+
+    if (next == nullptr)
+    {
+        return false;
+    }
+
+    // The next node becomes the new stub once its entry is taken.
+    // Copying rather than moving keeps the storage of both entries for reuse.
+    entry = next->entry;
+
+    _releaseNode(_front);
+    _front = next;
+
+    return true;
+}
+
+
+void ConcurrentEventQueue::reserve(std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        _releaseNode(new Node());
+    }
+}
+
+
+void ConcurrentEventQueue::_push(Node* node)
+{
+    node->next.store(nullptr, std::memory_order_relaxed);
+
+    // Claim the back of the queue, then link the previous back to the node.
+    // Until the link is stored, the consumer simply sees a shorter queue.
+    Node* previous = _back.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+}
+
+
+ConcurrentEventQueue::Node* ConcurrentEventQueue::_acquireNode()
+{
+    if (!_takingSpare.test_and_set(std::memory_order_acquire))
+    {
+        Node* node = _spares.load(std::memory_order_acquire);
+
+        // The consumer may push spares concurrently, but no other producer
+        // pops, so the top node and its nextSpare cannot change under us
+        // unless a push intervenes, which the exchange detects.
+        while (node != nullptr &&
+               !_spares.compare_exchange_weak(node,
+                                              node->nextSpare,
+                                              std::memory_order_acquire,
+                                              std::memory_order_acquire))
+        {
+        }
+
+        _takingSpare.clear(std::memory_order_release);
+
+        if (node != nullptr)
+        {
+            return node;
+        }
+    }
+
+    return new Node();
+}
+
+
+void ConcurrentEventQueue::_releaseNode(Node* node)
+{
+    Node* top = _spares.load(std::memory_order_relaxed);
+
+    do
+    {
+        node->nextSpare = top;
+    }
+    while (!_spares.compare_exchange_weak(top,
+                                          node,
+                                          std::memory_order_release,
+                                          std::memory_order_relaxed));
+}
+
+
+} } // namespace ofx::DOM
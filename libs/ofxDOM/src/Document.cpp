@@ -6,163 +6,1219 @@
 
 
 #include "ofx/DOM/Document.h"
+#include "ofx/DOM/ShapeKernels.h"
 #include "ofGraphics.h"
 #include "ofAppRunner.h"
+#include <algorithm>
+#include <utility>
 
 
 namespace ofx {
 namespace DOM {
 
 
+const std::size_t Document::MAX_CACHED_SELECTORS = 256;
+
+
 Document::Document(ofAppBaseWindow* window): Element("document", 0, 0, 1024, 768)
 {
     _window = window;
 
-    if (_window)
+    if (_window)
+    {
+        _pointerEventListener = PointerEventsManager::instance().eventsForWindow(_window)->pointerEvent.newListener(this, &Document::onPointerEvent, std::numeric_limits<int>::lowest());
+    }
+    else
+    {
+        _pointerEventListener = PointerEventsManager::instance().events()->pointerEvent.newListener(this, &Document::onPointerEvent, std::numeric_limits<int>::lowest());
+    }
+
+    ofCoreEvents& events = _window ? _window->events() : ofEvents();
+
+    _setupListener = events.setup.newListener(this, &Document::setup);
+    _updateListener = events.update.newListener(this, &Document::update);
+    _drawListener = events.draw.newListener(this, &Document::draw, std::numeric_limits<int>::max());
+    _exitListener = events.exit.newListener(this, &Document::exit);
+
+    _windowResizedListener = events.windowResized.newListener(this, &Document::windowResized, std::numeric_limits<int>::lowest());
+    _fileDroppedListener = events.fileDragEvent.newListener(this, &Document::fileDragEvent, std::numeric_limits<int>::lowest());
+    _keyPressedListener = events.keyPressed.newListener(this, &Document::onKeyEvent, std::numeric_limits<int>::lowest());
+    _keyReleasedListener = events.keyReleased.newListener(this, &Document::onKeyEvent, std::numeric_limits<int>::lowest());
+
+    // Injecting events from other threads should not wait on the allocator.
+    _injectedEvents.reserve(EventQueue::DEFAULT_CAPACITY);
+
+    addToIndexes(this);
+}
+
+
+Document::~Document()
+{
+    for (MutationObserver* observer : _mutationObservers)
+    {
+        observer->_document = nullptr;
+        observer->_targets.clear();
+        observer->_records.clear();
+    }
+}
+
+
+void Document::setup(ofEventArgs& e)
+{
+    if (_autoFillScreen)
+    {
+        setSize(ofGetWidth(), ofGetHeight());
+    }
+
+    Element::_setup(e);
+}
+
+
+void Document::update(ofEventArgs& e)
+{
+    flushInjectedEvents();
+    flushEvents();
+    flushPointerMoves();
+    deliverMutationRecords();
+
+    Element::_update(e);
+}
+
+
+void Document::draw(ofEventArgs& e)
+{
+    Element::_draw(e);
+}
+
+
+void Document::exit(ofEventArgs& e)
+{
+    Element::_exit(e);
+}
+
+
+void Document::windowResized(ofResizeEventArgs& e)
+{
+    if (_autoFillScreen)
+    {
+        setSize(e.width, e.height);
+    }
+}
+
+
+bool Document::fileDragEvent(ofDragInfo& e)
+{
+    return false;
+}
+
+
+bool Document::onKeyEvent(ofKeyEventArgs& e)
+{
+    if (_inputRecorder != nullptr)
+    {
+        _inputRecorder->record(e);
+    }
+
+    if (_eventQueueing)
+    {
+        _eventQueue.push(e);
+        return false;
+    }
+
+    return handleKeyEvent(e);
+}
+
+
+bool Document::handleKeyEvent(ofKeyEventArgs& e)
+{
+    if (_focusedElement != nullptr)
+    {
+        KeyboardUIEventArgs keyboardEvent(e, this, _focusedElement);
+        _focusedElement->dispatchEvent(keyboardEvent);
+    }
+
+    return false;
+}
+
+
+void Document::setAutoFillScreen(bool autoFillScreen)
+{
+    _autoFillScreen = autoFillScreen;
+
+    if (_autoFillScreen)
+    {
+        setSize(ofGetWidth(), ofGetHeight());
+    }
+}
+
+
+bool Document::getAutoFillScreen() const
+{
+    return _autoFillScreen;
+}
+
+
+void Document::setIncrementalHitTesting(bool incrementalHitTesting)
+{
+    _incrementalHitTesting = incrementalHitTesting;
+}
+
+
+bool Document::getIncrementalHitTesting() const
+{
+    return _incrementalHitTesting;
+}
+
+
+Element* Document::getElementById(const std::string& id)
+{
+    auto iter = _elementsById.find(id);
+
+    if (iter == _elementsById.end())
+    {
+        return nullptr;
+    }
+
+    const std::vector<Element*>& elements = iter->second;
+
+    Element* first = elements.front();
+
+    for (std::size_t i = 1; i < elements.size(); ++i)
+    {
+        if (precedes(elements[i], first))
+        {
+            first = elements[i];
+        }
+    }
+
+    return first;
+}
+
+
+std::vector<Element*> Document::getElementsById(const std::string& id)
+{
+    auto iter = _elementsById.find(id);
+
+    if (iter == _elementsById.end())
+    {
+        return std::vector<Element*>();
+    }
+
+    std::vector<Element*> elements = iter->second;
+    std::sort(elements.begin(), elements.end(), &Document::precedes);
+    return elements;
+}
+
+
+void Document::setGeometryStoreEnabled(bool enabled)
+{
+    if (enabled && !_ownedGeometryStore)
+    {
+        _ownedGeometryStore = std::make_unique<GeometryStore>(this);
+    }
+    else if (!enabled && _ownedGeometryStore)
+    {
+        _detachGeometryStore();
+        _ownedGeometryStore.reset();
+    }
+}
+
+
+bool Document::isGeometryStoreEnabled() const
+{
+    return _ownedGeometryStore != nullptr;
+}
+
+
+GeometryStore* Document::geometryStore()
+{
+    return _ownedGeometryStore.get();
+}
+
+
+void Document::setPointerMoveCoalescing(bool pointerMoveCoalescing)
+{
+    _pointerMoveCoalescing = pointerMoveCoalescing;
+
+    if (!_pointerMoveCoalescing)
+    {
+        flushPointerMoves();
+    }
+}
+
+
+bool Document::getPointerMoveCoalescing() const
+{
+    return _pointerMoveCoalescing;
+}
+
+
+void Document::setPointerMovePredictionCount(std::size_t count)
+{
+    _pointerMovePredictionCount = count;
+}
+
+
+std::size_t Document::getPointerMovePredictionCount() const
+{
+    return _pointerMovePredictionCount;
+}
+
+
+std::size_t Document::flushPointerMoves()
+{
+    std::size_t numHandled = 0;
+
+    while (!_coalescedPointerIds.empty())
+    {
+        if (flushPointerMoves(_coalescedPointerIds.front()))
+        {
+            ++numHandled;
+        }
+    }
+
+    return numHandled;
+}
+
+
+void Document::setEventQueueing(bool eventQueueing)
+{
+    _eventQueueing = eventQueueing;
+
+    if (_eventQueueing)
+    {
+        _eventQueue.reserve(EventQueue::DEFAULT_CAPACITY);
+        _flushingEventQueue.reserve(EventQueue::DEFAULT_CAPACITY);
+    }
+    else
+    {
+        flushEvents();
+    }
+}
+
+
+bool Document::getEventQueueing() const
+{
+    return _eventQueueing;
+}
+
+
+std::size_t Document::flushEvents()
+{
+    _eventQueue.swap(_flushingEventQueue);
+
+    std::size_t numHandled = 0;
+
+    while (!_flushingEventQueue.empty())
+    {
+        EventQueue::Entry& entry = _flushingEventQueue.front();
+
+        bool wasEventHandled = false;
+
+        switch (entry.type)
+        {
+            case EventQueue::Entry::Type::POINTER:
+                wasEventHandled = handlePointerEvent(entry.pointer);
+                break;
+            case EventQueue::Entry::Type::KEY:
+                wasEventHandled = handleKeyEvent(entry.key);
+                break;
+        }
+
+        if (wasEventHandled)
+        {
+            ++numHandled;
+        }
+
+        _flushingEventQueue.pop();
+    }
+
+    return numHandled;
+}
+
+
+void Document::injectPointerEvent(const PointerEventArgs& e)
+{
+    _injectedEvents.push(e);
+}
+
+
+void Document::injectKeyEvent(const ofKeyEventArgs& e)
+{
+    _injectedEvents.push(e);
+}
+
+
+std::size_t Document::flushInjectedEvents()
+{
+    std::size_t numHandled = 0;
+
+    while (_injectedEvents.pop(_injectedEvent))
+    {
+        bool wasEventHandled = false;
+
+        switch (_injectedEvent.type)
+        {
+            case EventQueue::Entry::Type::POINTER:
+                wasEventHandled = onPointerEvent(_injectedEvent.pointer);
+                break;
+            case EventQueue::Entry::Type::KEY:
+                wasEventHandled = onKeyEvent(_injectedEvent.key);
+                break;
+        }
+
+        if (wasEventHandled)
+        {
+            ++numHandled;
+        }
+    }
+
+    return numHandled;
+}
+
+
+void Document::setInputRecorder(InputRecorder* recorder)
+{
+    _inputRecorder = recorder;
+}
+
+
+InputRecorder* Document::getInputRecorder() const
+{
+    return _inputRecorder;
+}
+
+
+std::size_t Document::deliverMutationRecords()
+{
+    std::size_t numRecords = 0;
+
+    // Callbacks may connect or disconnect observers, so iterate over a copy.
+    std::vector<MutationObserver*> observers = _mutationObservers;
+
+    for (MutationObserver* observer : observers)
+    {
+        // Skip observers disconnected or destroyed by an earlier callback.
+        if (std::find(_mutationObservers.begin(),
+                      _mutationObservers.end(),
+                      observer) == _mutationObservers.end())
+        {
+            continue;
+        }
+
+        if (observer->_records.empty())
+        {
+            continue;
+        }
+
+        std::vector<MutationRecord> records;
+        records.swap(observer->_records);
+
+        numRecords += records.size();
+
+        observer->_callback(records, *observer);
+    }
+
+    return numRecords;
+}
+
+
+void Document::addMutationObserver(MutationObserver* observer)
+{
+    _mutationObservers.push_back(observer);
+}
+
+
+void Document::removeMutationObserver(MutationObserver* observer)
+{
+    _mutationObservers.erase(std::remove(_mutationObservers.begin(),
+                                         _mutationObservers.end(),
+                                         observer),
+                             _mutationObservers.end());
+}
+
+
+bool Document::hasMutationObservers() const
+{
+    return !_mutationObservers.empty();
+}
+
+
+void Document::queueMutationRecord(const MutationRecord& record)
+{
+    for (MutationObserver* observer : _mutationObservers)
+    {
+        if (observer->matches(record))
+        {
+            observer->_records.push_back(record);
+        }
+    }
+}
+
+
+void Document::removeMutationTargets(Element* subtree)
+{
+    for (MutationObserver* observer : _mutationObservers)
+    {
+        auto& records = observer->_records;
+
+        records.erase(std::remove_if(records.begin(),
+                                     records.end(),
+                                     [&](const MutationRecord& record) {
+                                         return isInSubtree(record.target(), subtree);
+                                     }),
+                      records.end());
+
+        auto& targets = observer->_targets;
+
+        targets.erase(std::remove_if(targets.begin(),
+                                     targets.end(),
+                                     [&](const std::pair<Element*, MutationObserverInit>& observed) {
+                                         return isInSubtree(observed.first, subtree);
+                                     }),
+                      targets.end());
+    }
+}
+
+
+void Document::removePointerTargets(Element* subtree)
+{
+    // Erasing swaps the last entry into place, so only advance past entries
+    // that are kept.
+    for (auto iter = _activeTargets.begin(); iter != _activeTargets.end();)
+    {
+        if (isInSubtree(iter->second, subtree))
+        {
+            _activeTargets.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    for (auto iter = _capturedPointerIdToElementMap.begin(); iter != _capturedPointerIdToElementMap.end();)
+    {
+        if (isInSubtree(iter->second, subtree))
+        {
+            // The capture ends without a lostpointercapture event because the
+            // Element may be destroyed before it could be delivered.
+            iter->second->_capturedPointers.clear();
+            _capturedPointerIdToElementMap.erase(iter);
+        }
+        else
+        {
+            ++iter;
+        }
+    }
+
+    if (isInSubtree(_focusedElement, subtree))
+    {
+        _focusedElement->_focused = false;
+        _focusedElement = nullptr;
+    }
+}
+
+
+bool Document::isInSubtree(const Element* element, const Element* subtree)
+{
+    for (; element != nullptr; element = element->parent())
+    {
+        if (element == subtree)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+bool Document::onPointerEvent(PointerEventArgs& e)
+{
+    if (_inputRecorder != nullptr)
+    {
+        _inputRecorder->record(e);
+    }
+
+    if (_eventQueueing)
+    {
+        _eventQueue.push(e);
+        return false;
+    }
+
+    return handlePointerEvent(e);
+}
+
+
+bool Document::handlePointerEvent(PointerEventArgs& e)
+{
+    if (_pointerMoveCoalescing)
+    {
+        if (e.eventType() == PointerEventArgs::POINTER_MOVE)
+        {
+            auto& samples = _coalescedPointerMoves[e.pointerId()];
+
+            if (samples.empty())
+            {
+                _coalescedPointerIds.push_back(e.pointerId());
+            }
+
+            samples.push_back(e);
+
+            // The event will be dispatched later.
+            return false;
+        }
+
+        // Keep the events for this pointer in order.
+        flushPointerMoves(e.pointerId());
+    }
+
+    return dispatchPointerEvent(e, findPointerTarget(e));
+}
+
+
+Element* Document::findPointerTarget(const PointerEventArgs& e)
+{
+    // The last element that the current pointer was hitting.
+    Element* lastActiveTarget = findElementInMap(e.pointerId(), _activeTargets);
+
+    if (_incrementalHitTesting && lastActiveTarget != nullptr)
+    {
+        return seededHitTest(lastActiveTarget, e.position());
+    }
+
+    return fullHitTest(e.position());
+}
+
+
+void Document::addToIndexes(Element* subtree)
+{
+    addToIdIndex(subtree->_id, subtree);
+
+    for (const auto& attribute : subtree->_attributes)
+    {
+        addToAttributeIndex(*attribute.key, subtree);
+    }
+
+    for (const auto& typeTag : _typeTags)
+    {
+        if (typeTag.second(subtree))
+        {
+            _elementsByTypeTag[typeTag.first].insert(subtree);
+        }
+    }
+
+    for (auto& child : subtree->_children)
+    {
+        addToIndexes(child.get());
+    }
+}
+
+
+void Document::removeFromIndexes(Element* subtree)
+{
+    removeFromIdIndex(subtree->_id, subtree);
+
+    for (const auto& attribute : subtree->_attributes)
+    {
+        removeFromAttributeIndex(*attribute.key, subtree);
+    }
+
+    for (auto& elements : _elementsByTypeTag)
+    {
+        elements.second.erase(subtree);
+    }
+
+    for (auto& child : subtree->_children)
+    {
+        removeFromIndexes(child.get());
+    }
+}
+
+
+void Document::addToIdIndex(const std::string& id, Element* element)
+{
+    if (!id.empty())
+    {
+        _elementsById[id].push_back(element);
+    }
+}
+
+
+void Document::removeFromIdIndex(const std::string& id, Element* element)
+{
+    auto iter = _elementsById.find(id);
+
+    if (iter != _elementsById.end())
+    {
+        std::vector<Element*>& elements = iter->second;
+
+        auto elementIter = std::find(elements.begin(), elements.end(), element);
+
+        if (elementIter != elements.end())
+        {
+            // The order of Elements sharing an id is not significant.
+            *elementIter = elements.back();
+            elements.pop_back();
+        }
+
+        if (elements.empty())
+        {
+            _elementsById.erase(iter);
+        }
+    }
+}
+
+
+void Document::addToAttributeIndex(const std::string& name, Element* element)
+{
+    _elementsByAttribute[name].insert(element);
+}
+
+
+void Document::removeFromAttributeIndex(const std::string& name, Element* element)
+{
+    auto iter = _elementsByAttribute.find(name);
+
+    if (iter != _elementsByAttribute.end())
+    {
+        iter->second.erase(element);
+
+        if (iter->second.empty())
+        {
+            _elementsByAttribute.erase(iter);
+        }
+    }
+}
+
+
+void Document::registerTypeTag(const std::string& tag,
+                               std::function<bool(const Element*)> test)
+{
+    auto iter = std::find_if(_typeTags.begin(),
+                             _typeTags.end(),
+                             [&](const std::pair<std::string, std::function<bool(const Element*)>>& typeTag) {
+                                 return typeTag.first == tag;
+                             });
+
+    if (iter != _typeTags.end())
+    {
+        iter->second = test;
+    }
+    else
+    {
+        _typeTags.push_back(std::make_pair(tag, test));
+    }
+
+    // Index the existing tree with the new test.
+    std::unordered_set<Element*>& elements = _elementsByTypeTag[tag];
+    elements.clear();
+
+    std::vector<Element*> pending(1, this);
+
+    while (!pending.empty())
+    {
+        Element* element = pending.back();
+        pending.pop_back();
+
+        if (test(element))
+        {
+            elements.insert(element);
+        }
+
+        for (auto& child : element->_children)
+        {
+            pending.push_back(child.get());
+        }
+    }
+}
+
+
+void Document::query(const std::string& selectors,
+                     Element* scope,
+                     bool firstOnly,
+                     std::vector<Element*>& results)
+{
+    auto iter = _selectors.find(selectors);
+
+    if (iter == _selectors.end())
+    {
+        // Compile before evicting, so an invalid selector keeps the cache.
+        Selector selector(selectors);
+
+        if (_selectors.size() >= MAX_CACHED_SELECTORS)
+        {
+            _selectors.clear();
+        }
+
+        iter = _selectors.emplace(selectors, std::move(selector)).first;
+    }
+
+    Selector& selector = iter->second;
+    selector.resolveKeys();
+
+    std::vector<Element*> candidates;
+
+    bool isTreeOrder = selector.alternatives().size() == 1;
+
+    for (const Selector::Complex& complex : selector.alternatives())
+    {
+        std::size_t subject = complex.compounds.size() - 1;
+
+        candidates.clear();
+        isTreeOrder = findCandidates(complex.compounds[subject], scope, candidates) && isTreeOrder;
+
+        for (Element* candidate : candidates)
+        {
+            if (matches(candidate, complex.compounds[subject])
+            &&  matchesAncestors(candidate, complex, subject))
+            {
+                results.push_back(candidate);
+
+                // The first match in tree order is the answer.
+                if (firstOnly && isTreeOrder)
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    if (results.size() > 1 && !isTreeOrder)
+    {
+        if (firstOnly)
+        {
+            auto first = std::min_element(results.begin(), results.end(), &Document::precedes);
+            std::swap(results.front(), *first);
+            results.resize(1);
+        }
+        else
+        {
+            std::sort(results.begin(), results.end(), &Document::precedes);
+            results.erase(std::unique(results.begin(), results.end()), results.end());
+        }
+    }
+}
+
+
+bool Document::findCandidates(const Selector::Compound& compound,
+                              Element* scope,
+                              std::vector<Element*>& candidates)
+{
+    auto inScope = [&](Element* element) {
+        for (Element* ancestor = element->_parent; ancestor != nullptr; ancestor = ancestor->_parent)
+        {
+            if (ancestor == scope)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+    // An id is the most selective index.
+    if (!compound.id.empty())
+    {
+        auto iter = _elementsById.find(compound.id);
+
+        if (iter != _elementsById.end())
+        {
+            for (Element* element : iter->second)
+            {
+                if (inScope(element))
+                {
+                    candidates.push_back(element);
+                }
+            }
+        }
+
+        return false;
+    }
+
+    // Otherwise use the smallest of the type tag and attribute indexes.
+    const std::unordered_set<Element*>* smallest = nullptr;
+
+    if (!compound.typeTag.empty())
+    {
+        auto iter = _elementsByTypeTag.find(compound.typeTag);
+
+        // Unregistered type tags match nothing.
+        if (iter == _elementsByTypeTag.end())
+        {
+            return false;
+        }
+
+        smallest = &iter->second;
+    }
+
+    for (const Selector::Attribute& attribute : compound.attributes)
     {
-        _pointerEventListener = PointerEventsManager::instance().eventsForWindow(_window)->pointerEvent.newListener(this, &Document::onPointerEvent, std::numeric_limits<int>::lowest());
+        auto iter = _elementsByAttribute.find(attribute.name);
+
+        if (iter == _elementsByAttribute.end())
+        {
+            return false;
+        }
+
+        if (smallest == nullptr || iter->second.size() < smallest->size())
+        {
+            smallest = &iter->second;
+        }
     }
-    else
+
+    if (smallest)
     {
-        _pointerEventListener = PointerEventsManager::instance().events()->pointerEvent.newListener(this, &Document::onPointerEvent, std::numeric_limits<int>::lowest());
+        for (Element* element : *smallest)
+        {
+            if (inScope(element))
+            {
+                candidates.push_back(element);
+            }
+        }
+
+        return false;
     }
 
-    ofCoreEvents& events = _window ? _window->events() : ofEvents();
+    // Without an index, walk the descendants in tree order.
+    std::vector<Element*> pending;
 
-    _setupListener = events.setup.newListener(this, &Document::setup);
-    _updateListener = events.update.newListener(this, &Document::update);
-    _drawListener = events.draw.newListener(this, &Document::draw, std::numeric_limits<int>::max());
-    _exitListener = events.exit.newListener(this, &Document::exit);
+    for (auto iter = scope->_children.rbegin(); iter != scope->_children.rend(); ++iter)
+    {
+        pending.push_back(iter->get());
+    }
 
-    _windowResizedListener = events.windowResized.newListener(this, &Document::windowResized, std::numeric_limits<int>::lowest());
-    _fileDroppedListener = events.fileDragEvent.newListener(this, &Document::fileDragEvent, std::numeric_limits<int>::lowest());
-    _keyPressedListener = events.keyPressed.newListener(this, &Document::onKeyEvent, std::numeric_limits<int>::lowest());
-    _keyReleasedListener = events.keyReleased.newListener(this, &Document::onKeyEvent, std::numeric_limits<int>::lowest());
+    while (!pending.empty())
+    {
+        Element* element = pending.back();
+        pending.pop_back();
 
-}
+        candidates.push_back(element);
 
+        for (auto iter = element->_children.rbegin(); iter != element->_children.rend(); ++iter)
+        {
+            pending.push_back(iter->get());
+        }
+    }
 
-Document::~Document()
-{
+    return true;
 }
 
 
-void Document::setup(ofEventArgs& e)
+bool Document::matches(Element* element, const Selector::Compound& compound) const
 {
-    if (_autoFillScreen)
+    if (!compound.id.empty() && element->_id != compound.id)
     {
-        setSize(ofGetWidth(), ofGetHeight());
+        return false;
     }
 
-    Element::_setup(e);
-}
+    if (!compound.typeTag.empty())
+    {
+        auto iter = _elementsByTypeTag.find(compound.typeTag);
 
+        if (iter == _elementsByTypeTag.end() || iter->second.count(element) == 0)
+        {
+            return false;
+        }
+    }
 
-void Document::update(ofEventArgs& e)
-{
-    Element::_update(e);
-}
+    for (const Selector::Attribute& attribute : compound.attributes)
+    {
+        // An unregistered name cannot be set on any Element.
+        if (attribute.key == nullptr)
+        {
+            return false;
+        }
 
+        const Any* value = element->_attributes.find(attribute.key);
 
-void Document::draw(ofEventArgs& e)
-{
-    Element::_draw(e);
-}
+        if (value == nullptr)
+        {
+            return false;
+        }
 
+        if (attribute.hasValue)
+        {
+            if (value->is<std::string>())
+            {
+                if (value->as<std::string>() != attribute.value)
+                {
+                    return false;
+                }
+            }
+            else if (value->is<const char*>())
+            {
+                if (attribute.value != value->as<const char*>())
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+        }
+    }
 
-void Document::exit(ofEventArgs& e)
-{
-    Element::_exit(e);
+    return true;
 }
 
 
-void Document::windowResized(ofResizeEventArgs& e)
+bool Document::matchesAncestors(Element* element,
+                                const Selector::Complex& complex,
+                                std::size_t index) const
 {
-    if (_autoFillScreen)
+    if (index == 0)
     {
-        setSize(e.width, e.height);
+        return true;
+    }
+
+    const Selector::Compound& compound = complex.compounds[index - 1];
+
+    if (complex.combinators[index - 1] == Selector::Combinator::CHILD)
+    {
+        Element* parent = element->_parent;
+
+        return parent
+            && matches(parent, compound)
+            && matchesAncestors(parent, complex, index - 1);
+    }
+
+    for (Element* ancestor = element->_parent; ancestor != nullptr; ancestor = ancestor->_parent)
+    {
+        if (matches(ancestor, compound) && matchesAncestors(ancestor, complex, index - 1))
+        {
+            return true;
+        }
     }
+
+    return false;
 }
 
 
-bool Document::fileDragEvent(ofDragInfo& e)
+bool Document::precedes(const Element* a, const Element* b)
 {
-    return false;
+    std::size_t depthA = 0;
+    std::size_t depthB = 0;
+
+    for (const Element* element = a->_parent; element != nullptr; element = element->_parent)
+    {
+        ++depthA;
+    }
+
+    for (const Element* element = b->_parent; element != nullptr; element = element->_parent)
+    {
+        ++depthB;
+    }
+
+    // Lift the deeper Element to the depth of the other.
+    const Element* ancestorA = a;
+    const Element* ancestorB = b;
+
+    for (; depthA > depthB; --depthA)
+    {
+        ancestorA = ancestorA->_parent;
+    }
+
+    for (; depthB > depthA; --depthB)
+    {
+        ancestorB = ancestorB->_parent;
+    }
+
+    // If one Element is an ancestor of the other, it precedes the other.
+    if (ancestorA == ancestorB)
+    {
+        return ancestorA == a && a != b;
+    }
+
+    while (ancestorA->_parent != ancestorB->_parent)
+    {
+        ancestorA = ancestorA->_parent;
+        ancestorB = ancestorB->_parent;
+    }
+
+    return ancestorA->_childIndex < ancestorB->_childIndex;
 }
 
 
-bool Document::onKeyEvent(ofKeyEventArgs& e)
+Element* Document::fullHitTest(const Position& screenPosition)
 {
-    if (_focusedElement != nullptr)
+    if (_ownedGeometryStore)
     {
-        KeyboardUIEventArgs keyboardEvent(e, this, _focusedElement);
-        _focusedElement->dispatchEvent(keyboardEvent);
+        return _ownedGeometryStore->hitTest(screenPosition);
     }
 
-    return false;
+    return recursiveHitTest(screenToParent(screenPosition));
 }
 
 
-void Document::setAutoFillScreen(bool autoFillScreen)
+bool Document::flushPointerMoves(std::size_t id)
 {
-    _autoFillScreen = autoFillScreen;
+    auto idIter = std::find(_coalescedPointerIds.begin(),
+                            _coalescedPointerIds.end(),
+                            id);
 
-    if (_autoFillScreen)
+    if (idIter == _coalescedPointerIds.end())
     {
-        setSize(ofGetWidth(), ofGetHeight());
+        return false;
+    }
+
+    _coalescedPointerIds.erase(idIter);
+
+    // Listeners may move pointers or flush again while the samples are being
+    // dispatched, so take the samples and predictions out of the Document
+    // first. Swapping moves the storage without copying or allocating.
+    std::vector<PointerEventArgs> samples;
+    samples.swap(_coalescedPointerMoves[id]);
+
+    std::vector<Position> predictedPositions;
+    predictedPositions.swap(_predictedPositions);
+    predictedPositions.clear();
+
+    // The last sample is dispatched on behalf of all of them.
+    PointerEventArgs& e = samples.back();
+
+    if (_pointerMovePredictionCount > 0)
+    {
+        // Extrapolate from the previous sample, which may have been
+        // dispatched in an earlier frame.
+        const PointerEventArgs* previous = nullptr;
+
+        if (samples.size() > 1)
+        {
+            previous = &samples[samples.size() - 2];
+        }
+        else
+        {
+            auto pointerIter = _activePointers.find(id);
+
+            if (pointerIter != _activePointers.end())
+            {
+                previous = &pointerIter->second;
+            }
+        }
+
+        if (previous != nullptr)
+        {
+            Position velocity = e.position() - previous->position();
+
+            for (std::size_t i = 1; i <= _pointerMovePredictionCount; ++i)
+            {
+                predictedPositions.push_back(e.position() + velocity * float(i));
+            }
+        }
     }
+
+    bool wasEventHandled = dispatchPointerEvent(e,
+                                                findPointerTarget(e),
+                                                &samples,
+                                                &predictedPositions);
+
+    // Give the storage back for the next frame, unless a listener queued new
+    // samples for this pointer in the meantime.
+    std::vector<PointerEventArgs>& pendingSamples = _coalescedPointerMoves[id];
+
+    if (pendingSamples.empty())
+    {
+        samples.clear();
+        pendingSamples.swap(samples);
+    }
+
+    _predictedPositions.swap(predictedPositions);
+
+    return wasEventHandled;
 }
 
 
-bool Document::getAutoFillScreen() const
+std::size_t Document::onPointerEvents(std::vector<PointerEventArgs>& events)
 {
-    return _autoFillScreen;
+    if (_inputRecorder != nullptr)
+    {
+        for (const PointerEventArgs& e : events)
+        {
+            _inputRecorder->record(e);
+        }
+    }
+
+    // Keep the events for each pointer in order.
+    flushPointerMoves();
+
+    _batchPositions.clear();
+    _batchIndices.clear();
+    _batchTargets.assign(events.size(), nullptr);
+
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        _batchPositions.push_back(events[i].position());
+        _batchIndices.push_back(i);
+    }
+
+    // Find all targets in a single traversal.
+    recursiveHitTest(_batchPositions,
+                     parentToScreen(Position()),
+                     _batchIndices,
+                     _batchTargets,
+                     _batchScratch);
+
+    std::size_t numHandled = 0;
+
+    for (std::size_t i = 0; i < events.size(); ++i)
+    {
+        if (dispatchPointerEvent(events[i], _batchTargets[i]))
+        {
+            ++numHandled;
+        }
+    }
+
+    return numHandled;
 }
 
 
-bool Document::onPointerEvent(PointerEventArgs& e)
+bool Document::dispatchPointerEvent(PointerEventArgs& e,
+                                    Element* activeTarget,
+                                    const std::vector<PointerEventArgs>* coalescedEvents,
+                                    const std::vector<Position>* predictedPositions)
 {
     // Determine if the event was handled.
     bool wasEventHandled = false;
 
+    // Intern the event type once rather than comparing strings.
+    EventTypeId eventType = EventTypeRegistry::idForType(e.eventType());
+
     // Add this pointer to the list of active pointers.
     _activePointers[e.pointerId()] = e;
 
     // The last element that the current pointer was hitting.
     Element* lastActiveTarget = findElementInMap(e.pointerId(), _activeTargets);
 
-    // The Element that the pointer is currently hitting.
-    // Find the current active target.
-    // TODO: Use lastActiveTarget to seed target search?
-    Element* activeTarget = recursiveHitTest(screenToParent(e.position()));
-
     // TODO: Quick and dirty.
-    if (e.eventType() == PointerEventArgs::POINTER_DOWN && activeTarget != nullptr && activeTarget->isFocusable() && capturedPointers().empty())
+    if (eventType == EventTypeRegistry::POINTER_DOWN && activeTarget != nullptr && activeTarget->isFocusable() && capturedPointers().empty())
     {
         if (_focusedElement != nullptr && _focusedElement != activeTarget)
         {
             Element* _lastFocusedElement = nullptr;
 
-            FocusEventArgs focusOut(FocusEventArgs::FOCUS_OUT,
+            FocusEventArgs focusOut(EventTypeRegistry::FOCUS_OUT,
                                     this,
                                     _focusedElement,
                                     activeTarget);
 
             _focusedElement->dispatchEvent(focusOut);
 
-            FocusEventArgs focusIn(FocusEventArgs::FOCUS_IN,
-                                    this,
-                                    activeTarget,
-                                    _focusedElement);
+            FocusEventArgs focusIn(EventTypeRegistry::FOCUS_IN,
+                                   this,
+                                   activeTarget,
+                                   _focusedElement);
 
             activeTarget->dispatchEvent(focusIn);
 
             _focusedElement->_focused = false;
 
-            FocusEventArgs blur(FocusEventArgs::BLUR,
-                                   this,
-                                   _focusedElement,
-                                   activeTarget);
+            FocusEventArgs blur(EventTypeRegistry::BLUR,
+                                this,
+                                _focusedElement,
+                                activeTarget);
 
             _focusedElement->dispatchEvent(blur);
 
@@ -171,7 +1227,7 @@ bool Document::onPointerEvent(PointerEventArgs& e)
 
             activeTarget->_focused = true;
 
-            FocusEventArgs focus(FocusEventArgs::FOCUS,
+            FocusEventArgs focus(EventTypeRegistry::FOCUS,
                                  this,
                                  _focusedElement,
                                  _lastFocusedElement);
@@ -181,7 +1237,7 @@ bool Document::onPointerEvent(PointerEventArgs& e)
         }
         else
         {
-            FocusEventArgs focusIn(FocusEventArgs::FOCUS_IN,
+            FocusEventArgs focusIn(EventTypeRegistry::FOCUS_IN,
                                    this,
                                    activeTarget,
                                    nullptr);
@@ -192,7 +1248,7 @@ bool Document::onPointerEvent(PointerEventArgs& e)
 
             activeTarget->_focused = true;
 
-            FocusEventArgs focus(FocusEventArgs::FOCUS,
+            FocusEventArgs focus(EventTypeRegistry::FOCUS,
                                  this,
                                  _focusedElement,
                                  nullptr);
@@ -212,7 +1268,7 @@ bool Document::onPointerEvent(PointerEventArgs& e)
     // capture the pointer.
     if (eventTarget == nullptr &&
         activeTarget != nullptr &&
-        e.eventType() == PointerEventArgs::POINTER_DOWN &&
+        eventType == EventTypeRegistry::POINTER_DOWN &&
         activeTarget->getImplicitPointerCapture())
     {
         eventTarget = activeTarget;
@@ -249,8 +1305,8 @@ bool Document::onPointerEvent(PointerEventArgs& e)
     // Here we handle a special case for non-hover sythesized pointer events.
     if (activeTarget != nullptr &&
         e.deviceType() != PointerEventArgs::TYPE_MOUSE &&
-        (e.eventType() == PointerEventArgs::POINTER_UP ||
-         e.eventType() == PointerEventArgs::POINTER_CANCEL))
+        (eventType == EventTypeRegistry::POINTER_UP ||
+         eventType == EventTypeRegistry::POINTER_CANCEL))
     {
         if (activeTarget == eventTarget)
         {
@@ -266,7 +1322,9 @@ bool Document::onPointerEvent(PointerEventArgs& e)
     }
 
     // Create a DOM pointer event.
-    PointerUIEventArgs event(e, this, eventTarget);
+    PointerUIEventArgs event(eventType, e, this, eventTarget);
+    event._coalescedEvents = coalescedEvents;
+    event._predictedPositions = predictedPositions;
 
     // Now, dispatch the original event if there is a target.
     // If eventTarget != nullptr, that means the current pointer id is captured.
@@ -296,8 +1354,8 @@ bool Document::onPointerEvent(PointerEventArgs& e)
         }
 
         // Release pointer capture if needed.
-        if (e.eventType() == PointerEventArgs::POINTER_UP ||
-            e.eventType() == PointerEventArgs::POINTER_CANCEL)
+        if (eventType == EventTypeRegistry::POINTER_UP ||
+            eventType == EventTypeRegistry::POINTER_CANCEL)
         {
             releasePointerCaptureForElement(eventTarget, e.pointerId());
         }
@@ -312,8 +1370,8 @@ bool Document::onPointerEvent(PointerEventArgs& e)
 
     // Manage active targets and pointers lists.
     if (e.deviceType() != PointerEventArgs::TYPE_MOUSE
-    && (e.eventType() == PointerEventArgs::POINTER_UP ||
-        e.eventType() == PointerEventArgs::POINTER_CANCEL))
+    && (eventType == EventTypeRegistry::POINTER_UP ||
+        eventType == EventTypeRegistry::POINTER_CANCEL))
     {
         _activeTargets.erase(e.pointerId());
         _activePointers.erase(e.pointerId());
@@ -367,8 +1425,6 @@ void Document::setPointerCaptureForElement(Element* element, std::size_t id)
 
 void Document::releasePointerCaptureForElement(Element* element, std::size_t id)
 {
-    // TODO: release if the target element is removed from the document.
-
     if (element != nullptr)
     {
         auto activePointersIter = _activePointers.find(id);
@@ -413,14 +1469,111 @@ Element* Document::findElementInMap(std::size_t id, PointerElementMap& pem)
 }
 
 
+Element* Document::seededHitTest(Element* seed, const Position& screenPosition)
+{
+    // Active targets are erased when they leave the Document, so the seed is
+    // always a live Element in this Document.
+    Element* candidate = seed;
+
+    while (candidate != nullptr)
+    {
+        Position parentPosition = candidate->screenToParent(screenPosition);
+
+        if (candidate->getTotalShape().inside(parentPosition))
+        {
+            // If something is in front of the candidate, we can't be sure
+            // of the result without a full search.
+            if (!isExposed(candidate, screenPosition))
+            {
+                break;
+            }
+
+            Element* target = candidate->recursiveHitTest(parentPosition);
+
+            if (target != nullptr)
+            {
+                return target;
+            }
+        }
+
+        candidate = candidate->_parent;
+    }
+
+    return fullHitTest(screenPosition);
+}
+
+
+bool Document::isExposed(Element* element, const Position& screenPosition)
+{
+    Element* child = element;
+    Element* parent = element->_parent;
+
+    while (parent != nullptr)
+    {
+        Position localPosition = parent->screenToLocal(screenPosition);
+
+        if (!parent->_enabled || parent->_hidden || !parent->childHitTest(localPosition))
+        {
+            return false;
+        }
+
+        std::size_t childIndex = child->_childIndex;
+
+        if (parent->_spatialIndex)
+        {
+            // Candidates are sorted front to back.
+            for (std::size_t index : parent->_spatialIndex->query(localPosition))
+            {
+                if (index >= childIndex)
+                {
+                    break;
+                }
+                else if (parent->_children[index]->getTotalShape().inside(localPosition))
+                {
+                    return false;
+                }
+            }
+        }
+        else if (childIndex > 0)
+        {
+            // The child edges are valid with the child shape.
+            parent->getChildShape();
+
+            std::size_t numChildren = parent->_children.size();
+
+            const float* left = parent->_childEdges.data();
+            const float* top = left + numChildren;
+            const float* right = top + numChildren;
+            const float* bottom = right + numChildren;
+
+            if (ShapeKernels::findContaining(left,
+                                             top,
+                                             right,
+                                             bottom,
+                                             0,
+                                             childIndex,
+                                             localPosition.x,
+                                             localPosition.y) < childIndex)
+            {
+                return false;
+            }
+        }
+
+        child = parent;
+        parent = parent->_parent;
+    }
+
+    return true;
+}
+
+
 void Document::synthesizePointerOutAndLeave(const PointerEventArgs& e,
                                             Element* target,
                                             Element* relatedTarget)
 {
-    PointerEventArgs pointerOut(PointerEventArgs::POINTER_OUT, e);
-
     // Call pointerout ONLY on old target
-    PointerUIEventArgs pointerOutEvent(pointerOut,
+    PointerUIEventArgs pointerOutEvent(EventTypeRegistry::POINTER_OUT,
+                                       e,
                                        this,
                                        target,
                                        relatedTarget);
@@ -429,15 +1582,23 @@ void Document::synthesizePointerOutAndLeave(const PointerEventArgs& e,
 
     target->handleEvent(pointerOutEvent);
 
-    PointerEventArgs pointerLeave(PointerEventArgs::POINTER_LEAVE, e);
+    // Call pointerleave on the old target AND the ancestors that do not
+    // contain the new target, from the innermost to the outermost. Each
+    // pointerleave passes through the capture phase of its own ancestors.
+    Element* ancestor = findCommonAncestor(target, relatedTarget);
 
-    // Call pointerleave on old target AND ancestors.
-    PointerUIEventArgs pointerLeaveEvent(pointerLeave,
-                                         this,
-                                         target,
-                                         relatedTarget);
+    for (Element* element = target;
+         element != nullptr && element != ancestor;
+         element = element->parent())
+    {
+        PointerUIEventArgs pointerLeaveEvent(EventTypeRegistry::POINTER_LEAVE,
+                                             e,
+                                             this,
+                                             element,
+                                             relatedTarget);
 
-    target->dispatchEvent(pointerLeaveEvent);
+        element->dispatchEvent(pointerLeaveEvent);
+    }
 }
 
 
@@ -445,10 +1606,9 @@ void Document::synthesizePointerOverAndEnter(const PointerEventArgs& e,
                                              Element* target,
                                              Element* relatedTarget)
 {
-    PointerEventArgs pointerOver(PointerEventArgs::POINTER_OVER, e);
-
     // Call pointerout ONLY on old target
-    PointerUIEventArgs pointerOverEvent(pointerOver,
+    PointerUIEventArgs pointerOverEvent(EventTypeRegistry::POINTER_OVER,
+                                        e,
                                         this,
                                         target,
                                         relatedTarget);
@@ -457,17 +1617,93 @@ void Document::synthesizePointerOverAndEnter(const PointerEventArgs& e,
 
     target->handleEvent(pointerOverEvent);
 
-    PointerEventArgs pointerEnter(PointerEventArgs::POINTER_ENTER, e);
-
     // Call pointerover ONLY on the target.
-    // Call pointerenter on target and ancestors.
-    // Call pointerleave on old target and ancestors
-    PointerUIEventArgs pointerEnterEvent(pointerEnter,
-                                         this,
-                                         target,
-                                         relatedTarget);
-
-    target->dispatchEvent(pointerEnterEvent);
+    // Call pointerenter on the target AND the ancestors that did not contain
+    // the old target, from the outermost to the innermost. Each pointerenter
+    // passes through the capture phase of its own ancestors.
+    Element* ancestor = findCommonAncestor(target, relatedTarget);
+
+    std::size_t numEntered = 0;
+
+    for (Element* element = target;
+         element != nullptr && element != ancestor;
+         element = element->parent())
+    {
+        ++numEntered;
+    }
+
+    // Listeners may cause nested pointer events, so the entered Elements are
+    // kept locally. They are stored inline unless the tree is unusually deep.
+    Element* inlineEntered[INLINE_PATH_CAPACITY];
+    std::vector<Element*> overflowEntered;
+
+    Element** entered = inlineEntered;
+
+    if (numEntered > INLINE_PATH_CAPACITY)
+    {
+        overflowEntered.resize(numEntered);
+        entered = overflowEntered.data();
+    }
+
+    Element* element = target;
+
+    for (std::size_t i = 0; i < numEntered; ++i)
+    {
+        entered[i] = element;
+        element = element->parent();
+    }
+
+    for (std::size_t i = numEntered; i-- > 0;)
+    {
+        PointerUIEventArgs pointerEnterEvent(EventTypeRegistry::POINTER_ENTER,
+                                             e,
+                                             this,
+                                             entered[i],
+                                             relatedTarget);
+
+        entered[i]->dispatchEvent(pointerEnterEvent);
+    }
+}
+
+
+Element* Document::findCommonAncestor(Element* a, Element* b)
+{
+    if (a == nullptr || b == nullptr)
+    {
+        return nullptr;
+    }
+
+    std::size_t depthA = 0;
+    std::size_t depthB = 0;
+
+    for (Element* element = a->parent(); element != nullptr; element = element->parent())
+    {
+        ++depthA;
+    }
+
+    for (Element* element = b->parent(); element != nullptr; element = element->parent())
+    {
+        ++depthB;
+    }
+
+    // Move the deeper Element up until both are at the same depth.
+    for (; depthA > depthB; --depthA)
+    {
+        a = a->parent();
+    }
+
+    for (; depthB > depthA; --depthB)
+    {
+        b = b->parent();
+    }
+
+    while (a != b)
+    {
+        a = a->parent();
+        b = b->parent();
+    }
+
+    return a;
 }
 
 
@@ -7,6 +7,7 @@
 
 #include "ofx/DOM/Element.h"
 #include "ofx/DOM/Document.h"
+#include "ofx/DOM/ShapeKernels.h"
 #include "ofGraphics.h"
 #include <algorithm>
 
@@ -43,18 +44,46 @@ std::unique_ptr<Element> Element::removeChild(Element* element)
 
     if (iter != _children.end())
     {
+        std::size_t index = iter - _children.begin();
+
         // Move the child out of the children array.
         std::unique_ptr<Element> detachedChild = std::move(*iter);
 
         // Disown the detached child
         _children.erase(iter);
 
+        // The children after the detached child moved forward.
+        _reindexChildren(index, _children.size());
+
         // Set the parent to nullptr.
         detachedChild->_parent = nullptr;
 
+        // The child's listeners no longer receive events through this Element.
+        updateSubtreeListenerCounts(*detachedChild, false);
+
+        // The child's screen position is now its position.
+        detachedChild->_invalidateScreenPosition();
+
+        // The child's geometry is no longer stored with this Element's.
+        detachedChild->_detachGeometryStore();
+
+        // The child's subtree is no longer findable by id, attribute or type.
+        _removeFromIndexes(detachedChild.get());
+
         // Invalidate all cached child geometry.
         invalidateChildShape();
 
+        // The child indices have changed.
+        if (_spatialIndex)
+        {
+            _spatialIndex->invalidate();
+        }
+
+        if (_geometryStore)
+        {
+            _geometryStore->invalidate();
+        }
+
         // Alert the node that its parent was set.
         ElementEventArgs removedFromEvent(this);
         ofNotifyEvent(detachedChild->removedFrom, removedFromEvent, this);
@@ -62,6 +91,8 @@ std::unique_ptr<Element> Element::removeChild(Element* element)
         ElementEventArgs childRemovedEvent(detachedChild.get());
         ofNotifyEvent(childRemoved, childRemovedEvent, this);
 
+        _queueChildListMutation(nullptr, detachedChild.get());
+
         /// Alert the node's siblings that it no longer has a sibling.
         for (auto& child : _children)
         {
@@ -132,15 +163,13 @@ void Element::moveChildToIndex(Element* element, std::size_t index)
         std::size_t oldIndex = iter - _children.begin();
         std::size_t newIndex = std::min(index, _children.size() - 1);
 
-        auto detachedChild = std::move(*iter);
-
-        _children.erase(iter);
-
-        _children.insert(_children.begin() + newIndex, std::move(detachedChild));
+        _moveChild(oldIndex, newIndex);
 
         ElementOrderEventArgs e(element, oldIndex, newIndex);
         ofNotifyEvent(reordered, e, element);
         ofNotifyEvent(childReordered, e, this);
+
+        _queueChildOrderMutation(element, oldIndex, newIndex);
     }
     else
     {
@@ -158,13 +187,13 @@ void Element::moveChildToFront(Element* element)
         std::size_t oldIndex = iter - _children.begin();
         std::size_t newIndex = 0;
 
-        auto detachedChild = std::move(*iter);
-        _children.erase(iter);
-        _children.insert(_children.begin(), std::move(detachedChild));
+        _moveChild(oldIndex, newIndex);
 
         ElementOrderEventArgs e(element, oldIndex, newIndex);
         ofNotifyEvent(reordered, e, element);
         ofNotifyEvent(childReordered, e, this);
+
+        _queueChildOrderMutation(element, oldIndex, newIndex);
     }
     else
     {
@@ -185,11 +214,13 @@ void Element::moveChildForward(Element* element)
             std::size_t oldIndex = iter - _children.begin();
             std::size_t newIndex = oldIndex - 1;
 
-            std::iter_swap(iter, iter - 1);
+            _moveChild(oldIndex, newIndex);
 
             ElementOrderEventArgs e(element, oldIndex, newIndex);
             ofNotifyEvent(reordered, e, element);
             ofNotifyEvent(childReordered, e, this);
+
+            _queueChildOrderMutation(element, oldIndex, newIndex);
         }
     }
     else
@@ -211,13 +242,13 @@ void Element::moveChildToBack(Element* element)
             std::size_t oldIndex = iter - _children.begin();
             std::size_t newIndex = _children.size() - 1;
 
-            auto detachedChild = std::move(*iter);
-            _children.erase(iter);
-            _children.push_back(std::move(detachedChild));
+            _moveChild(oldIndex, newIndex);
 
             ElementOrderEventArgs e(element, oldIndex, newIndex);
             ofNotifyEvent(reordered, e, element);
             ofNotifyEvent(childReordered, e, this);
+
+            _queueChildOrderMutation(element, oldIndex, newIndex);
         }
     }
     else
@@ -236,13 +267,15 @@ void Element::moveChildBackward(Element* element)
         if (iter != _children.end() - 1)
         {
             std::size_t oldIndex = iter - _children.begin();
-            std::size_t newIndex = _children.size() + 1;
+            std::size_t newIndex = oldIndex + 1;
 
-            std::iter_swap(iter, iter + 1);
+            _moveChild(oldIndex, newIndex);
 
             ElementOrderEventArgs e(element, oldIndex, newIndex);
             ofNotifyEvent(reordered, e, element);
             ofNotifyEvent(childReordered, e, this);
+
+            _queueChildOrderMutation(element, oldIndex, newIndex);
         }
     }
 }
@@ -384,11 +417,42 @@ std::vector<Element*> Element::findChildrenById(const std::string& id)
 
 std::vector<std::unique_ptr<Element>>::iterator Element::findChild(Element* element)
 {
-    return std::find_if(_children.begin(),
-                        _children.end(),
-                        [&](const std::unique_ptr<Element>& child) {
-                            return element == child.get();
-                        });
+    if (element && element->_parent == this)
+    {
+        return _children.begin() + element->_childIndex;
+    }
+
+    return _children.end();
+}
+
+
+Element* Element::querySelector(const std::string& selectors)
+{
+    Document* document = this->document();
+
+    if (!document)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "Element::querySelector: The Element is not in a Document.");
+    }
+
+    std::vector<Element*> results;
+    document->query(selectors, this, true, results);
+    return results.empty() ? nullptr : results.front();
+}
+
+
+std::vector<Element*> Element::querySelectorAll(const std::string& selectors)
+{
+    Document* document = this->document();
+
+    if (!document)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "Element::querySelectorAll: The Element is not in a Document.");
+    }
+
+    std::vector<Element*> results;
+    document->query(selectors, this, false, results);
+    return results;
 }
 
 
@@ -443,6 +507,25 @@ bool Element::childHitTest(const Position& localPosition) const
 }
 
 
+void Element::setSpatialIndexEnabled(bool enabled)
+{
+    if (enabled && !_spatialIndex)
+    {
+        _spatialIndex = std::make_unique<SpatialIndex>(this);
+    }
+    else if (!enabled)
+    {
+        _spatialIndex.reset();
+    }
+}
+
+
+bool Element::isSpatialIndexEnabled() const
+{
+    return _spatialIndex != nullptr;
+}
+
+
 Position Element::localToScreen(const Position& localPosition) const
 {
     return localPosition + getScreenPosition();;
@@ -480,6 +563,13 @@ Position Element::screenToParent(const Position& screenPosition) const
 void Element::setPosition(float x, float y)
 {
     _shape.setPosition(x, y);
+    _invalidateScreenPosition();
+
+    if (_geometryStore)
+    {
+        _geometryStore->update(_geometrySlot);
+    }
+
     MoveEventArgs e(getPosition());
     ofNotifyEvent(move, e, this);
 }
@@ -511,12 +601,21 @@ float Element::getY() const
 
 Position Element::getScreenPosition() const
 {
-    if (_parent)
+    if (_screenPositionInvalid)
     {
-        return getPosition() + _parent->getScreenPosition();
+        if (_parent)
+        {
+            _screenPosition = getPosition() + _parent->getScreenPosition();
+        }
+        else
+        {
+            _screenPosition = getPosition();
+        }
+
+        _screenPositionInvalid = false;
     }
 
-    return getPosition();
+    return _screenPosition;
 }
 
 
@@ -534,9 +633,23 @@ float Element::getScreenY() const
 
 void Element::setSize(float width, float height)
 {
+    Position position = getPosition();
+
     _shape.setWidth(width);
     _shape.setHeight(height);
     _shape.standardize();
+
+    // A negative width or height moves the origin.
+    if (getPosition() != position)
+    {
+        _invalidateScreenPosition();
+    }
+
+    if (_geometryStore)
+    {
+        _geometryStore->update(_geometrySlot);
+    }
+
     ResizeEventArgs e(_shape);
     ofNotifyEvent(resize, e, this);
 }
@@ -577,31 +690,58 @@ Shape Element::getChildShape() const
 {
     if (_childShapeInvalid)
     {
-        _childShape = Shape(); // Clear.
+        std::size_t numChildren = _children.size();
+
+        _childEdges.resize(numChildren * 4);
 
-        auto iter = _children.begin();
+        float* left = _childEdges.data();
+        float* top = left + numChildren;
+        float* right = top + numChildren;
+        float* bottom = right + numChildren;
 
-        while (iter != _children.end())
+        for (std::size_t i = 0; i < numChildren; ++i)
         {
-            const Element* child = iter->get();
+            const Element* child = _children[i].get();
 
-            if (child)
-            {
-                if (iter == _children.begin())
-                {
-                    _childShape = child->getTotalShape();
-                }
-                else
-                {
-                    _childShape.growToInclude(child->getTotalShape());
-                }
-            }
-            else
+            if (child == nullptr)
             {
                 throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "Element::getChildGeometry(): Child element is nullptr.");
             }
 
-            ++iter;
+            Shape totalShape = child->getTotalShape();
+
+            left[i] = totalShape.getMinX();
+            top[i] = totalShape.getMinY();
+            right[i] = totalShape.getMaxX();
+            bottom[i] = totalShape.getMaxY();
+        }
+
+        if (numChildren > 0)
+        {
+            float boundsLeft = left[0];
+            float boundsTop = top[0];
+            float boundsRight = right[0];
+            float boundsBottom = bottom[0];
+
+            ShapeKernels::growToInclude(left,
+                                        top,
+                                        right,
+                                        bottom,
+                                        1,
+                                        numChildren,
+                                        boundsLeft,
+                                        boundsTop,
+                                        boundsRight,
+                                        boundsBottom);
+
+            _childShape = Shape(boundsLeft,
+                                boundsTop,
+                                boundsRight - boundsLeft,
+                                boundsBottom - boundsTop);
+        }
+        else
+        {
+            _childShape = Shape(); // Clear.
         }
 
         _childShapeInvalid = false;
@@ -624,7 +764,7 @@ Shape Element::getTotalShape() const
 }
 
 
-std::string Element::getId() const
+const std::string& Element::getId() const
 {
     return _id;
 }
@@ -632,33 +772,57 @@ std::string Element::getId() const
 
 void Element::setId(const std::string& id)
 {
+    Document* document = this->document();
+
+    if (document)
+    {
+        document->removeFromIdIndex(_id, this);
+        document->addToIdIndex(id, this);
+    }
+
     _id = id;
 }
 
 
 bool Element::hasAttribute(const std::string& key) const
 {
-    return _attributes.find(key) != _attributes.end();
+    return _attributes.find(key) != nullptr;
 }
 
 
 void Element::setAttribute(const std::string& key, const Any& value)
 {
-    _attributes[key] = value;
+    if (_attributes.set(key, value))
+    {
+        _addToAttributeIndex(key);
+    }
 
     AttributeEventArgs e(key, value);
     ofNotifyEvent(attributeSet, e, this);
+
+    _queueAttributeMutation(key);
 }
 
 
 void Element::clearAttribute(const std::string& key)
 {
-    _attributes.erase(key);
+    if (_attributes.erase(key))
+    {
+        _removeFromAttributeIndex(key);
+    }
+
     AttributeEventArgs e(key);
     ofNotifyEvent(attributeCleared, e, this);
+
+    _queueAttributeMutation(key);
 }
 
 
+const AttributeStore& Element::attributes() const
+{
+    return _attributes;
+}
+
 
 void Element::_setup(ofEventArgs& e)
 {
@@ -730,13 +894,52 @@ Element* Element::recursiveHitTest(const Position& parentPosition)
 
         if (!_children.empty() && childHitTest(childLocal))
         {
-            for (auto& child : _children)
+            if (_spatialIndex)
             {
-                Element* target = child->recursiveHitTest(childLocal);
+                // Candidates are sorted front to back.
+                for (std::size_t index : _spatialIndex->query(childLocal))
+                {
+                    Element* target = _children[index]->recursiveHitTest(childLocal);
 
-                if (target)
+                    if (target)
+                    {
+                        return target;
+                    }
+                }
+            }
+            else
+            {
+                // The child edges are valid with the child shape.
+                getChildShape();
+
+                std::size_t numChildren = _children.size();
+
+                const float* left = _childEdges.data();
+                const float* top = left + numChildren;
+                const float* right = top + numChildren;
+                const float* bottom = right + numChildren;
+
+                // Only children whose total shape contains the position can
+                // be hit, so skip straight from one such child to the next.
+                std::size_t index = 0;
+
+                while ((index = ShapeKernels::findContaining(left,
+                                                             top,
+                                                             right,
+                                                             bottom,
+                                                             index,
+                                                             numChildren,
+                                                             childLocal.x,
+                                                             childLocal.y)) < numChildren)
                 {
-                    return target;
+                    Element* target = _children[index]->recursiveHitTest(childLocal);
+
+                    if (target)
+                    {
+                        return target;
+                    }
+
+                    ++index;
                 }
             }
         }
@@ -756,6 +959,176 @@ Element* Element::recursiveHitTest(const Position& parentPosition)
 }
 
 
+void Element::recursiveHitTest(const std::vector<Position>& screenPositions,
+                               const Position& parentScreenPosition,
+                               std::vector<std::size_t>& indices,
+                               std::vector<Element*>& targets,
+                               std::deque<HitTestScratch>& scratch,
+                               std::size_t depth)
+{
+    if (!_enabled || _hidden || indices.empty())
+    {
+        return;
+    }
+
+    Position screenPosition = parentScreenPosition + getPosition();
+
+    if (!_children.empty())
+    {
+        typedef HitTestScratch::Pending Pending;
+
+        // A deque keeps the buffers of shallower levels in place as it grows.
+        if (scratch.size() <= depth)
+        {
+            scratch.resize(depth + 1);
+        }
+
+        std::vector<Pending>& pending = scratch[depth].pending;
+        std::vector<Pending>& assigned = scratch[depth].assigned;
+        std::vector<std::size_t>& subset = scratch[depth].subset;
+
+        // The child edges are valid with the child shape.
+        getChildShape();
+
+        std::size_t numChildren = _children.size();
+
+        const float* left = _childEdges.data();
+        const float* top = left + numChildren;
+        const float* right = top + numChildren;
+        const float* bottom = right + numChildren;
+
+        pending.clear();
+        pending.reserve(indices.size());
+
+        for (std::size_t index : indices)
+        {
+            if (childHitTest(screenPositions[index] - screenPosition))
+            {
+                pending.push_back({ index, 0, 0 });
+            }
+        }
+
+        while (!pending.empty())
+        {
+            assigned.clear();
+
+            // Assign each position to the next child that may contain it.
+            for (Pending& p : pending)
+            {
+                Position localPosition = screenPositions[p.index] - screenPosition;
+
+                float x = localPosition.x;
+                float y = localPosition.y;
+
+                if (_spatialIndex)
+                {
+                    const std::vector<std::size_t>& candidates = _spatialIndex->query(localPosition);
+
+                    while (p.cursor < candidates.size())
+                    {
+                        std::size_t child = candidates[p.cursor];
+
+                        ++p.cursor;
+
+                        // Matches Shape::inside(), as the packed scan does.
+                        if (x > left[child] && y > top[child] && x < right[child] && y < bottom[child])
+                        {
+                            p.child = child;
+                            assigned.push_back(p);
+                            break;
+                        }
+                    }
+                }
+                else if (p.cursor < numChildren)
+                {
+                    std::size_t child = ShapeKernels::findContaining(left,
+                                                                     top,
+                                                                     right,
+                                                                     bottom,
+                                                                     p.cursor,
+                                                                     numChildren,
+                                                                     x,
+                                                                     y);
+
+                    p.cursor = child + 1;
+
+                    if (child < numChildren)
+                    {
+                        p.child = child;
+                        assigned.push_back(p);
+                    }
+                }
+            }
+
+            pending.clear();
+
+            // Search each child once for all of its positions.
+            std::sort(assigned.begin(),
+                      assigned.end(),
+                      [](const Pending& a, const Pending& b) {
+                          return a.child < b.child;
+                      });
+
+            auto first = assigned.begin();
+
+            while (first != assigned.end())
+            {
+                auto last = std::find_if(first,
+                                         assigned.end(),
+                                         [&](const Pending& p) {
+                                             return p.child != first->child;
+                                         });
+
+                subset.clear();
+
+                for (auto iter = first; iter != last; ++iter)
+                {
+                    subset.push_back(iter->index);
+                }
+
+                _children[first->child]->recursiveHitTest(screenPositions,
+                                                          screenPosition,
+                                                          subset,
+                                                          targets,
+                                                          scratch,
+                                                          depth + 1);
+
+                // Positions that missed move on to their next candidate.
+                for (auto iter = first; iter != last; ++iter)
+                {
+                    if (targets[iter->index] == nullptr)
+                    {
+                        pending.push_back(*iter);
+                    }
+                }
+
+                first = last;
+            }
+        }
+    }
+
+    // If there is no child target, is this a viable target?
+    auto remaining = indices.begin();
+
+    for (std::size_t index : indices)
+    {
+        if (targets[index] == nullptr)
+        {
+            if (hitTest(screenPositions[index] - parentScreenPosition))
+            {
+                targets[index] = this;
+            }
+            else
+            {
+                *remaining++ = index;
+            }
+        }
+    }
+
+    indices.erase(remaining, indices.end());
+}
+
+
 void Element::setPointerCapture(std::size_t id)
 {
     Document* _document = document();
@@ -795,6 +1168,12 @@ bool Element::isEnabled() const
 void Element::setEnabled(bool enabled_)
 {
     _enabled = enabled_;
+
+    if (_geometryStore)
+    {
+        _geometryStore->update(_geometrySlot);
+    }
+
     EnablerEventArgs e(_enabled);
     ofNotifyEvent(enabled, e, this);
 }
@@ -809,6 +1188,12 @@ bool Element::isHidden() const
 void Element::setHidden(bool hidden_)
 {
     _hidden = hidden_;
+
+    if (_geometryStore)
+    {
+        _geometryStore->update(_geometrySlot);
+    }
+
     EnablerEventArgs e(_hidden);
     ofNotifyEvent(hidden, e, this);
 }
@@ -852,6 +1237,12 @@ void Element::invalidateChildShape() const
 
     if (_parent)
     {
+        // Our total shape may have changed.
+        if (_parent->_spatialIndex)
+        {
+            _parent->_spatialIndex->invalidate(this);
+        }
+
         _parent->invalidateChildShape();
     }
 
@@ -915,14 +1306,246 @@ bool Element::getImplicitPointerCapture() const
 }
 
 
-void Element::_onChildMoved(MoveEventArgs&)
+void Element::_invalidateScreenPosition()
+{
+    // If this Element is already invalid, so are all of its descendants.
+    if (!_screenPositionInvalid)
+    {
+        _screenPositionInvalid = true;
+
+        for (auto& child : _children)
+        {
+            child->_invalidateScreenPosition();
+        }
+    }
+}
+
+
+void Element::_moveChild(std::size_t oldIndex, std::size_t newIndex)
+{
+    if (oldIndex == newIndex)
+    {
+        return;
+    }
+
+    // Only the children between the old and new index change their index.
+    std::size_t first = std::min(oldIndex, newIndex);
+    std::size_t middle = newIndex < oldIndex ? oldIndex : oldIndex + 1;
+    std::size_t last = std::max(oldIndex, newIndex) + 1;
+
+    std::rotate(_children.begin() + first, _children.begin() + middle, _children.begin() + last);
+    _reindexChildren(first, last);
+
+    // The child shape is unchanged, but the child edges are in child order.
+    if (!_childShapeInvalid)
+    {
+        std::size_t numChildren = _children.size();
+
+        for (std::size_t edge = 0; edge < 4; ++edge)
+        {
+            auto edges = _childEdges.begin() + edge * numChildren;
+            std::rotate(edges + first, edges + middle, edges + last);
+        }
+    }
+
+    if (_spatialIndex)
+    {
+        _spatialIndex->moveChild(oldIndex, newIndex);
+    }
+
+    if (_geometryStore)
+    {
+        _geometryStore->moveChild(this, oldIndex, newIndex);
+    }
+}
+
+
+void Element::_reindexChildren(std::size_t first, std::size_t last)
 {
+    for (std::size_t index = first; index < last; ++index)
+    {
+        _children[index]->_childIndex = index;
+    }
+}
+
+
+void Element::_addToIndexes(Element* subtree)
+{
+    Document* document = this->document();
+
+    if (document)
+    {
+        document->addToIndexes(subtree);
+    }
+}
+
+
+void Element::_addToIndexes(const std::vector<Element*>& subtrees)
+{
+    Document* document = this->document();
+
+    if (document)
+    {
+        for (Element* subtree : subtrees)
+        {
+            document->addToIndexes(subtree);
+        }
+    }
+}
+
+
+void Element::_removeFromIndexes(Element* subtree)
+{
+    Document* document = this->document();
+
+    if (document)
+    {
+        document->removeFromIndexes(subtree);
+        document->removePointerTargets(subtree);
+
+        if (document->hasMutationObservers())
+        {
+            document->removeMutationTargets(subtree);
+        }
+    }
+}
+
+
+void Element::_addToAttributeIndex(const std::string& name)
+{
+    Document* document = this->document();
+
+    if (document)
+    {
+        document->addToAttributeIndex(name, this);
+    }
+}
+
+
+void Element::_removeFromAttributeIndex(const std::string& name)
+{
+    Document* document = this->document();
+
+    if (document)
+    {
+        document->removeFromAttributeIndex(name, this);
+    }
+}
+
+
+void Element::_detachGeometryStore()
+{
+    // If this Element is not stored, neither are its descendants.
+    if (_geometryStore)
+    {
+        _geometryStore = nullptr;
+        _geometrySlot = 0;
+
+        for (auto& child : _children)
+        {
+            child->_detachGeometryStore();
+        }
+    }
+}
+
+
+Document* Element::_mutationDocument()
+{
+    Document* document = this->document();
+
+    if (document && document->hasMutationObservers())
+    {
+        return document;
+    }
+
+    return nullptr;
+}
+
+
+void Element::_queueChildListMutation(Element* addedElement, Element* removedElement)
+{
+    Document* document = _mutationDocument();
+
+    if (document)
+    {
+        MutationRecord record(MutationRecord::Type::CHILD_LIST, this);
+
+        if (addedElement)
+        {
+            record._addedElements.push_back(addedElement);
+        }
+
+        if (removedElement)
+        {
+            record._removedElements.push_back(removedElement);
+        }
+
+        document->queueMutationRecord(record);
+    }
+}
+
+
+void Element::_queueChildListMutation(const std::vector<Element*>& addedElements)
+{
+    Document* document = _mutationDocument();
+
+    if (document)
+    {
+        MutationRecord record(MutationRecord::Type::CHILD_LIST, this);
+        record._addedElements = addedElements;
+        document->queueMutationRecord(record);
+    }
+}
+
+
+void Element::_queueChildOrderMutation(Element* element,
+                                       std::size_t oldIndex,
+                                       std::size_t newIndex)
+{
+    Document* document = _mutationDocument();
+
+    if (document)
+    {
+        MutationRecord record(MutationRecord::Type::CHILD_ORDER, this);
+        record._reorderedElement = element;
+        record._oldIndex = oldIndex;
+        record._newIndex = newIndex;
+        document->queueMutationRecord(record);
+    }
+}
+
+
+void Element::_queueAttributeMutation(const std::string& name)
+{
+    Document* document = _mutationDocument();
+
+    if (document)
+    {
+        MutationRecord record(MutationRecord::Type::ATTRIBUTES, this);
+        record._attributeName = name;
+        document->queueMutationRecord(record);
+    }
+}
+
+
+void Element::_onChildMoved(const void* sender, MoveEventArgs&)
+{
+    if (_spatialIndex)
+    {
+        _spatialIndex->invalidate(static_cast<const Element*>(sender));
+    }
+
     invalidateChildShape();
 }
 
 
-void Element::_onChildResized(ResizeEventArgs&)
+void Element::_onChildResized(const void* sender, ResizeEventArgs&)
 {
+    if (_spatialIndex)
+    {
+        _spatialIndex->invalidate(static_cast<const Element*>(sender));
+    }
+
     invalidateChildShape();
 }
 
@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/EventQueue.h"
+#include "ofx/DOM/Exceptions.h"
+#include <algorithm>
+#include <utility>
+
+
+namespace ofx {
+namespace DOM {
+
+
+const std::size_t EventQueue::DEFAULT_CAPACITY = 256;
+
+
+EventQueue::EventQueue()
+{
+}
+
+
+EventQueue::~EventQueue()
+{
+}
+
+
+void EventQueue::swap(EventQueue& other) noexcept
+{
+    _entries.swap(other._entries);
+    std::swap(_front, other._front);
+    std::swap(_size, other._size);
+}
+
+
+void EventQueue::push(const PointerEventArgs& e)
+{
+    Entry& entry = _pushBack();
+    entry.type = Entry::Type::POINTER;
+    entry.pointer = e;
+}
+
+
+void EventQueue::push(const ofKeyEventArgs& e)
+{
+    Entry& entry = _pushBack();
+    entry.type = Entry::Type::KEY;
+    entry.key = e;
+}
+
+
+EventQueue::Entry& EventQueue::front()
+{
+    if (_size == 0)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "EventQueue::front: The queue is empty.");
+    }
+
+    return _entries[_front];
+}
+
+
+void EventQueue::pop()
+{
+    if (_size > 0)
+    {
+        _front = (_front + 1) % _entries.size();
+        --_size;
+    }
+}
+
+
+void EventQueue::clear()
+{
+    _front = 0;
+    _size = 0;
+}
+
+
+bool EventQueue::empty() const
+{
+    return _size == 0;
+}
+
+
+std::size_t EventQueue::size() const
+{
+    return _size;
+}
+
+
+std::size_t EventQueue::capacity() const
+{
+    return _entries.size();
+}
+
+
+void EventQueue::reserve(std::size_t capacity)
+{
+    if (capacity <= _entries.size())
+    {
+        return;
+    }
+
+    // Unwrap the entries so the front is at index 0.
+    std::vector<Entry> entries(capacity);
+
+    for (std::size_t i = 0; i < _size; ++i)
+    {
+        entries[i] = std::move(_entries[(_front + i) % _entries.size()]);
+    }
+
+    _entries = std::move(entries);
+    _front = 0;
+}
+
+
+EventQueue::Entry& EventQueue::_pushBack()
+{
+    if (_size == _entries.size())
+    {
+        reserve(std::max(_entries.size() * 2, DEFAULT_CAPACITY));
+    }
+
+    Entry& entry = _entries[(_front + _size) % _entries.size()];
+    ++_size;
+    return entry;
+}
+
+
+} } // namespace ofx::DOM
@@ -13,13 +13,120 @@ namespace ofx {
 namespace DOM {
 
 
+EventTypeRegistry::BuiltInTypes::BuiltInTypes()
+{
+    // The order must match the built-in id enumeration.
+    for (const std::string& type: {
+        PointerEventArgs::POINTER_OVER,
+        PointerEventArgs::POINTER_ENTER,
+        PointerEventArgs::POINTER_DOWN,
+        PointerEventArgs::POINTER_MOVE,
+        PointerEventArgs::POINTER_UP,
+        PointerEventArgs::POINTER_CANCEL,
+        PointerEventArgs::POINTER_OUT,
+        PointerEventArgs::POINTER_LEAVE,
+        PointerEventArgs::POINTER_SCROLL,
+        PointerEventArgs::GOT_POINTER_CAPTURE,
+        PointerEventArgs::LOST_POINTER_CAPTURE,
+        KeyboardUIEventArgs::KEY_DOWN,
+        KeyboardUIEventArgs::KEY_UP,
+        FocusEventArgs::FOCUS_IN,
+        FocusEventArgs::FOCUS,
+        FocusEventArgs::FOCUS_OUT,
+        FocusEventArgs::BLUR })
+    {
+        ids[type] = types.size();
+        types.push_back(type);
+    }
+}
+
+
+EventTypeId EventTypeRegistry::idForType(const std::string& type)
+{
+    // The built-in types never change, so they are found without the lock.
+    const BuiltInTypes& builtIn = builtInTypes();
+
+    auto builtInIter = builtIn.ids.find(type);
+
+    if (builtInIter != builtIn.ids.end())
+    {
+        return builtInIter->second;
+    }
+
+    EventTypeRegistry& registry = instance();
+
+    std::unique_lock<std::mutex> lock(registry._mutex);
+
+    auto iter = registry._ids.find(type);
+
+    if (iter != registry._ids.end())
+    {
+        return iter->second;
+    }
+
+    EventTypeId id = NUM_BUILT_IN_TYPES + registry._types.size();
+    registry._ids[type] = id;
+    registry._types.push_back(type);
+    return id;
+}
+
+
+const std::string& EventTypeRegistry::typeForId(EventTypeId id)
+{
+    if (id < NUM_BUILT_IN_TYPES)
+    {
+        return builtInTypes().types[id];
+    }
+
+    EventTypeRegistry& registry = instance();
+
+    std::unique_lock<std::mutex> lock(registry._mutex);
+
+    if (id - NUM_BUILT_IN_TYPES < registry._types.size())
+    {
+        return registry._types[id - NUM_BUILT_IN_TYPES];
+    }
+
+    throw DOMException(DOMException::UNREGISTERED_EVENT + ": " + "EventTypeRegistry::typeForId");
+}
+
+
+std::size_t EventTypeRegistry::size()
+{
+    EventTypeRegistry& registry = instance();
+
+    std::unique_lock<std::mutex> lock(registry._mutex);
+
+    return NUM_BUILT_IN_TYPES + registry._types.size();
+}
+
+
+EventTypeRegistry::EventTypeRegistry()
+{
+}
+
+
+EventTypeRegistry& EventTypeRegistry::instance()
+{
+    static EventTypeRegistry registry;
+    return registry;
+}
+
+
+const EventTypeRegistry::BuiltInTypes& EventTypeRegistry::builtInTypes()
+{
+    static const BuiltInTypes types;
+    return types;
+}
+
+
 EventArgs::EventArgs(const std::string& type,
                      Element* source,
                      Element* target,
                      bool bubbles,
                      bool cancelable,
                      uint64_t timestamp):
-    EventArgs(type, source, target, nullptr, bubbles, cancelable, timestamp)
+    EventArgs(EventTypeRegistry::idForType(type), source, target, nullptr, bubbles, cancelable, timestamp)
 {
 }
 
@@ -31,7 +138,30 @@ EventArgs::EventArgs(const std::string& type,
                      bool bubbles,
                      bool cancelable,
                      uint64_t timestamp):
-    _type(type),
+    EventArgs(EventTypeRegistry::idForType(type), source, target, relatedTarget, bubbles, cancelable, timestamp)
+{
+}
+
+
+EventArgs::EventArgs(EventTypeId type,
+                     Element* source,
+                     Element* target,
+                     bool bubbles,
+                     bool cancelable,
+                     uint64_t timestamp):
+    EventArgs(type, source, target, nullptr, bubbles, cancelable, timestamp)
+{
+}
+
+
+EventArgs::EventArgs(EventTypeId type,
+                     Element* source,
+                     Element* target,
+                     Element* relatedTarget,
+                     bool bubbles,
+                     bool cancelable,
+                     uint64_t timestamp):
+    _typeId(type),
     _source(source),
     _target(target),
     _relatedTarget(relatedTarget),
@@ -49,7 +179,13 @@ EventArgs::~EventArgs()
 
 const std::string& EventArgs::type() const
 {
-    return _type;
+    return EventTypeRegistry::typeForId(_typeId);
+}
+
+
+EventTypeId EventArgs::typeId() const
+{
+    return _typeId;
 }
 
 
@@ -180,7 +316,7 @@ std::string EventArgs::toString() const
     }
 
 
-    ss << "Event Type: " << _type << std::endl;
+    ss << "Event Type: " << type() << std::endl;
     ss << "     Phase: " << phaseString << std::endl;
     ss << "    Source: " << (_source != nullptr ? _source->getId() : "nullptr") << std::endl;
     ss << "    Target: " << (_target != nullptr ? _target->getId() : "nullptr") << std::endl;
@@ -198,7 +334,7 @@ PointerCaptureUIEventArgs::PointerCaptureUIEventArgs(std::size_t id,
                                                      bool wasCaptured,
                                                      Element* source,
                                                      Element* target):
-    UIEventArgs((wasCaptured ? PointerEventArgs::GOT_POINTER_CAPTURE : PointerEventArgs::LOST_POINTER_CAPTURE),
+    UIEventArgs((wasCaptured ? EventTypeRegistry::GOT_POINTER_CAPTURE : EventTypeRegistry::LOST_POINTER_CAPTURE),
             source,
             target,
             true,
@@ -225,14 +361,28 @@ PointerUIEventArgs::PointerUIEventArgs(const PointerEventArgs& pointer,
                                        Element* source,
                                        Element* target,
                                        Element* relatedTarget):
-    UIEventArgs(pointer.eventType(),
+    PointerUIEventArgs(EventTypeRegistry::idForType(pointer.eventType()),
+                       pointer,
+                       source,
+                       target,
+                       relatedTarget)
+{
+}
+
+
+PointerUIEventArgs::PointerUIEventArgs(EventTypeId type,
+                                       const PointerEventArgs& pointer,
+                                       Element* source,
+                                       Element* target,
+                                       Element* relatedTarget):
+    UIEventArgs(type,
                 source,
                 target,
                 relatedTarget,
-            	eventBubbles(pointer.eventType()),
-                eventCancelable(pointer.eventType()),
+                eventBubbles(type),
+                eventCancelable(type),
                 pointer.timestampMillis()),
-    _pointer(pointer)
+    _pointer(&pointer)
 {
 }
 
@@ -244,7 +394,7 @@ PointerUIEventArgs::~PointerUIEventArgs()
 
 const PointerEventArgs& PointerUIEventArgs::pointer() const
 {
-    return _pointer;
+    return *_pointer;
 }
 
 
@@ -265,20 +415,34 @@ Position PointerUIEventArgs::localPosition() const
 }
 
 
-bool PointerUIEventArgs::eventBubbles(const std::string& event)
+const std::vector<PointerEventArgs>& PointerUIEventArgs::coalescedEvents() const
 {
-    return !(event == PointerEventArgs::POINTER_ENTER
-          || event == PointerEventArgs::POINTER_LEAVE);
+    static const std::vector<PointerEventArgs> empty;
+    return _coalescedEvents != nullptr ? *_coalescedEvents : empty;
 }
 
 
-bool PointerUIEventArgs::eventCancelable(const std::string& event)
+const std::vector<Position>& PointerUIEventArgs::predictedPositions() const
 {
-    return !(event == PointerEventArgs::POINTER_ENTER
-          || event == PointerEventArgs::POINTER_CANCEL
-          || event == PointerEventArgs::POINTER_LEAVE
-          || event == PointerEventArgs::GOT_POINTER_CAPTURE
-          || event == PointerEventArgs::LOST_POINTER_CAPTURE);
+    static const std::vector<Position> empty;
+    return _predictedPositions != nullptr ? *_predictedPositions : empty;
+}
+
+
+bool PointerUIEventArgs::eventBubbles(EventTypeId event)
+{
+    return !(event == EventTypeRegistry::POINTER_ENTER
+          || event == EventTypeRegistry::POINTER_LEAVE);
+}
+
+
+bool PointerUIEventArgs::eventCancelable(EventTypeId event)
+{
+    return !(event == EventTypeRegistry::POINTER_ENTER
+          || event == EventTypeRegistry::POINTER_CANCEL
+          || event == EventTypeRegistry::POINTER_LEAVE
+          || event == EventTypeRegistry::GOT_POINTER_CAPTURE
+          || event == EventTypeRegistry::LOST_POINTER_CAPTURE);
 }
 
 
@@ -289,7 +453,7 @@ const std::string KeyboardUIEventArgs::KEY_UP = "keyup";
 KeyboardUIEventArgs::KeyboardUIEventArgs(const ofKeyEventArgs& args,
                                          Element* source,
                                          Element* target):
-    UIEventArgs(args.type == ofKeyEventArgs::Pressed ? KEY_DOWN : KEY_UP,
+    UIEventArgs(args.type == ofKeyEventArgs::Pressed ? EventTypeRegistry::KEY_DOWN : EventTypeRegistry::KEY_UP,
                 source,
                 target,
                 true,
@@ -367,15 +531,26 @@ FocusEventArgs::FocusEventArgs(const std::string& type,
                                Element* source,
                                Element* target,
                                Element* relatedTarget):
+    FocusEventArgs(EventTypeRegistry::idForType(type),
+                   source,
+                   target,
+                   relatedTarget)
+{
+}
+
+
+FocusEventArgs::FocusEventArgs(EventTypeId type,
+                               Element* source,
+                               Element* target,
+                               Element* relatedTarget):
     EventArgs(type,
               source,
               target,
-              (type != FOCUS), // In the spec.
+              relatedTarget,
+              (type != EventTypeRegistry::FOCUS), // In the spec.
               false,
               ofGetElapsedTimeMillis())
 {
-    // TODO: better Event constructor.
-    _relatedTarget = relatedTarget;
 }
 
 
@@ -483,6 +658,23 @@ const Element* ElementEventArgs::element() const
 }
 
 
+ElementListEventArgs::ElementListEventArgs(std::vector<Element*> elements):
+    _elements(std::move(elements))
+{
+}
+
+
+ElementListEventArgs::~ElementListEventArgs()
+{
+}
+
+
+const std::vector<Element*>& ElementListEventArgs::elements() const
+{
+    return _elements;
+}
+
+
 ElementOrderEventArgs::ElementOrderEventArgs(Element* element,
                                              std::size_t oldIndex,
                                              std::size_t newIndex):
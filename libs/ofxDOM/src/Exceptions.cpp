@@ -16,6 +16,7 @@ const std::string DOMException::INVALID_POINTER_ID = "InvalidPointerId";
 const std::string DOMException::INVALID_STATE_ERROR = "InvalidStateError";
 const std::string DOMException::UNREGISTERED_EVENT = "UnregisteredEvent";
 const std::string DOMException::INVALID_ATTRIBUTE_KEY = "InvalidAttributeKey";
+const std::string DOMException::SYNTAX_ERROR = "SyntaxError";
 
 
 } } // namespace ofx::DOM
@@ -0,0 +1,340 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/GeometryStore.h"
+#include "ofx/DOM/Element.h"
+#include "ofx/DOM/ShapeKernels.h"
+#include <algorithm>
+
+
+namespace ofx {
+namespace DOM {
+
+
+namespace {
+
+
+/// \brief Move the value at one position to another, shifting the values
+/// in between by one place toward the old position.
+template <typename ValueType>
+void moveValue(std::vector<ValueType>& values, std::size_t oldIndex, std::size_t newIndex)
+{
+    auto begin = values.begin();
+
+    if (newIndex < oldIndex)
+    {
+        std::rotate(begin + newIndex, begin + oldIndex, begin + oldIndex + 1);
+    }
+    else
+    {
+        std::rotate(begin + oldIndex, begin + oldIndex + 1, begin + newIndex + 1);
+    }
+}
+
+
+} // namespace
+
+
+GeometryStore::GeometryStore(Element* root):
+    _root(root)
+{
+}
+
+
+GeometryStore::~GeometryStore()
+{
+}
+
+
+Element* GeometryStore::root()
+{
+    return _root;
+}
+
+
+void GeometryStore::invalidate()
+{
+    _invalid = true;
+}
+
+
+void GeometryStore::moveChild(const Element* parent, std::size_t oldIndex, std::size_t newIndex)
+{
+    // A full rebuild will pick up the new order anyway.
+    if (_invalid || oldIndex == newIndex)
+    {
+        return;
+    }
+
+    std::size_t first = _firstChildren[parent->_geometrySlot];
+    std::size_t oldSlot = first + oldIndex;
+    std::size_t newSlot = first + newIndex;
+
+    // The derived arrays are recomputed from these on the next query.
+    moveValue(_elements, oldSlot, newSlot);
+    moveValue(_firstChildren, oldSlot, newSlot);
+    moveValue(_numChildren, oldSlot, newSlot);
+    moveValue(_x, oldSlot, newSlot);
+    moveValue(_y, oldSlot, newSlot);
+    moveValue(_width, oldSlot, newSlot);
+    moveValue(_height, oldSlot, newSlot);
+    moveValue(_flags, oldSlot, newSlot);
+
+    // The children of the moved slots keep their slots, so only their parent
+    // slots change. Slots stay in breadth first levels, so parents still
+    // precede their children.
+    std::size_t begin = std::min(oldSlot, newSlot);
+    std::size_t end = std::max(oldSlot, newSlot) + 1;
+
+    for (std::size_t slot = begin; slot < end; ++slot)
+    {
+        _elements[slot]->_geometrySlot = slot;
+
+        std::size_t firstChild = _firstChildren[slot];
+
+        for (std::size_t child = firstChild; child < firstChild + _numChildren[slot]; ++child)
+        {
+            _parents[child] = uint32_t(slot);
+        }
+    }
+
+    _derivedInvalid = true;
+}
+
+
+bool GeometryStore::isValid() const
+{
+    return !_invalid;
+}
+
+
+void GeometryStore::update(std::size_t slot)
+{
+    // Changes made while invalid are read by the next rebuild.
+    if (_invalid)
+    {
+        return;
+    }
+
+    const Element* element = _elements[slot];
+
+    _x[slot] = element->_shape.x;
+    _y[slot] = element->_shape.y;
+    _width[slot] = element->_shape.width;
+    _height[slot] = element->_shape.height;
+    _flags[slot] = (element->_hidden ? HIDDEN : 0) | (element->_enabled ? 0 : DISABLED);
+
+    _derivedInvalid = true;
+}
+
+
+std::size_t GeometryStore::size()
+{
+    _validate();
+    return _elements.size();
+}
+
+
+Element* GeometryStore::hitTest(const Position& screenPosition)
+{
+    _validate();
+    return _hitTest(0, screenPosition.x, screenPosition.y);
+}
+
+
+std::size_t GeometryStore::cull(const Shape& screenShape, std::vector<Element*>& elements)
+{
+    _validate();
+
+    std::size_t numElements = elements.size();
+
+    float left = screenShape.getMinX();
+    float top = screenShape.getMinY();
+    float right = screenShape.getMaxX();
+    float bottom = screenShape.getMaxY();
+
+    for (std::size_t slot = 0; slot < _elements.size(); ++slot)
+    {
+        if (_effectiveFlags[slot] == 0
+        &&  _screenX[slot] < right
+        &&  _screenY[slot] < bottom
+        &&  _screenX[slot] + _width[slot] > left
+        &&  _screenY[slot] + _height[slot] > top)
+        {
+            elements.push_back(_elements[slot]);
+        }
+    }
+
+    return elements.size() - numElements;
+}
+
+
+void GeometryStore::_rebuild()
+{
+    _elements.clear();
+    _parents.clear();
+    _firstChildren.clear();
+    _numChildren.clear();
+
+    _elements.push_back(_root);
+    _parents.push_back(0);
+
+    // Breadth first, so the children of each slot are contiguous.
+    for (std::size_t slot = 0; slot < _elements.size(); ++slot)
+    {
+        Element* element = _elements[slot];
+
+        element->_geometryStore = this;
+        element->_geometrySlot = slot;
+
+        _firstChildren.push_back(uint32_t(_elements.size()));
+        _numChildren.push_back(uint32_t(element->_children.size()));
+
+        for (auto& child : element->_children)
+        {
+            _elements.push_back(child.get());
+            _parents.push_back(uint32_t(slot));
+        }
+    }
+
+    std::size_t numSlots = _elements.size();
+
+    _x.resize(numSlots);
+    _y.resize(numSlots);
+    _width.resize(numSlots);
+    _height.resize(numSlots);
+    _flags.resize(numSlots);
+    _effectiveFlags.resize(numSlots);
+    _screenX.resize(numSlots);
+    _screenY.resize(numSlots);
+    _totalLeft.resize(numSlots);
+    _totalTop.resize(numSlots);
+    _totalRight.resize(numSlots);
+    _totalBottom.resize(numSlots);
+
+    _invalid = false;
+
+    for (std::size_t slot = 0; slot < numSlots; ++slot)
+    {
+        update(slot);
+    }
+
+    _derivedInvalid = true;
+}
+
+
+void GeometryStore::_validate()
+{
+    if (_invalid)
+    {
+        _rebuild();
+    }
+
+    if (_derivedInvalid)
+    {
+        _derive();
+    }
+}
+
+
+void GeometryStore::_derive()
+{
+    std::size_t numSlots = _elements.size();
+
+    // Parents precede their children, so one forward pass resolves screen
+    // positions and inherited flags.
+    _screenX[0] = _x[0];
+    _screenY[0] = _y[0];
+    _effectiveFlags[0] = _flags[0];
+
+    for (std::size_t slot = 1; slot < numSlots; ++slot)
+    {
+        uint32_t parent = _parents[slot];
+        _screenX[slot] = _screenX[parent] + _x[slot];
+        _screenY[slot] = _screenY[parent] + _y[slot];
+        _effectiveFlags[slot] = _effectiveFlags[parent] | _flags[slot];
+    }
+
+    // Children follow their parents, so one backward pass resolves the
+    // total shapes.
+    for (std::size_t slot = numSlots; slot-- > 0;)
+    {
+        float left = _screenX[slot];
+        float top = _screenY[slot];
+        float right = left + _width[slot];
+        float bottom = top + _height[slot];
+
+        std::size_t first = _firstChildren[slot];
+
+        ShapeKernels::growToInclude(_totalLeft.data(),
+                                    _totalTop.data(),
+                                    _totalRight.data(),
+                                    _totalBottom.data(),
+                                    first,
+                                    first + _numChildren[slot],
+                                    left,
+                                    top,
+                                    right,
+                                    bottom);
+
+        _totalLeft[slot] = left;
+        _totalTop[slot] = top;
+        _totalRight[slot] = right;
+        _totalBottom[slot] = bottom;
+    }
+
+    _derivedInvalid = false;
+}
+
+
+Element* GeometryStore::_hitTest(std::size_t slot, float x, float y) const
+{
+    if (_flags[slot] != 0)
+    {
+        return nullptr;
+    }
+
+    std::size_t first = _firstChildren[slot];
+    std::size_t last = first + _numChildren[slot];
+
+    // Children are in front to back order. Nothing in a child's subtree can
+    // be hit outside of its total shape, so skip to the next child whose
+    // total shape contains the position.
+    std::size_t child = first;
+
+    while ((child = ShapeKernels::findContaining(_totalLeft.data(),
+                                                 _totalTop.data(),
+                                                 _totalRight.data(),
+                                                 _totalBottom.data(),
+                                                 child,
+                                                 last,
+                                                 x,
+                                                 y)) < last)
+    {
+        Element* target = _hitTest(child, x, y);
+
+        if (target)
+        {
+            return target;
+        }
+
+        ++child;
+    }
+
+    if (x > _screenX[slot]
+    &&  y > _screenY[slot]
+    &&  x < _screenX[slot] + _width[slot]
+    &&  y < _screenY[slot] + _height[slot])
+    {
+        return _elements[slot];
+    }
+
+    return nullptr;
+}
+
+
+} } // namespace ofx::DOM
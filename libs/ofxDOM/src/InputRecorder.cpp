@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/InputRecorder.h"
+#include "ofx/DOM/Types.h"
+#include <cstring>
+#include <type_traits>
+
+
+namespace ofx {
+namespace DOM {
+
+
+namespace {
+
+
+/// \brief Write an integer in little-endian byte order.
+template <typename Type>
+void write(std::ostream& stream, Type value)
+{
+    typedef typename std::make_unsigned<Type>::type Unsigned;
+
+    Unsigned bits = Unsigned(value);
+    char bytes[sizeof(Type)];
+
+    for (std::size_t i = 0; i < sizeof(Type); ++i)
+    {
+        bytes[i] = char(bits & 0xff);
+        bits = Unsigned(bits >> 8);
+    }
+
+    stream.write(bytes, sizeof(Type));
+}
+
+
+/// \brief Write a float as its IEEE 754 bits in little-endian byte order.
+void write(std::ostream& stream, float value)
+{
+    static_assert(sizeof(float) == sizeof(uint32_t), "Floats must be 32 bits.");
+
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    write(stream, bits);
+}
+
+
+} // namespace
+
+
+const uint32_t InputRecorder::MAGIC = 0x52494f44; // "DOIR"
+const uint32_t InputRecorder::VERSION = 2;
+
+
+InputRecorder::InputRecorder(std::ostream& stream):
+    _stream(stream),
+    _start(std::chrono::steady_clock::now())
+{
+    write(_stream, MAGIC);
+    write(_stream, VERSION);
+}
+
+
+InputRecorder::~InputRecorder()
+{
+    _stream.flush();
+}
+
+
+void InputRecorder::record(const PointerEventArgs& e)
+{
+    _writeRecordHeader(POINTER_RECORD);
+    _writePointer(e);
+}
+
+
+void InputRecorder::record(const ofKeyEventArgs& e)
+{
+    _writeRecordHeader(KEY_RECORD);
+
+    write(_stream, int32_t(e.type));
+    write(_stream, int32_t(e.key));
+    write(_stream, int32_t(e.keycode));
+    write(_stream, int32_t(e.scancode));
+    write(_stream, uint32_t(e.codepoint));
+    write(_stream, int32_t(e.modifiers));
+    write(_stream, uint8_t(e.isRepeat));
+}
+
+
+std::size_t InputRecorder::numRecords() const
+{
+    return _numRecords;
+}
+
+
+void InputRecorder::_writeRecordHeader(RecordType type)
+{
+    auto elapsed = std::chrono::steady_clock::now() - _start;
+
+    write(_stream, uint8_t(type));
+    write(_stream, uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+
+    ++_numRecords;
+}
+
+
+void InputRecorder::_writePointer(const PointerEventArgs& e)
+{
+    _writeString(e.eventType());
+    _writeString(e.deviceType());
+
+    const Point& point = e.point();
+    const PointShape& shape = point.shape();
+
+    Position position = point.position();
+
+    write(_stream, position.x);
+    write(_stream, position.y);
+    write(_stream, point.pressure());
+    write(_stream, point.tangentialPressure());
+    write(_stream, point.twistDeg());
+    write(_stream, point.tiltXDeg());
+    write(_stream, point.tiltYDeg());
+
+    write(_stream, uint8_t(shape.shapeType()));
+    write(_stream, shape.width());
+    write(_stream, shape.height());
+    write(_stream, shape.widthTolerance());
+    write(_stream, shape.heightTolerance());
+    write(_stream, shape.angleDeg());
+
+    write(_stream, uint64_t(e.timestampMicros()));
+    write(_stream, uint64_t(e.detail()));
+    write(_stream, uint64_t(e.pointerId()));
+    write(_stream, int64_t(e.deviceId()));
+    write(_stream, int64_t(e.pointerIndex()));
+    write(_stream, uint64_t(e.sequenceIndex()));
+    write(_stream, int32_t(e.button()));
+    write(_stream, int32_t(e.buttons()));
+    write(_stream, int32_t(e.modifiers()));
+
+    uint8_t flags = (e.canHover() ? CAN_HOVER : 0)
+                  | (e.isCoalesced() ? IS_COALESCED : 0)
+                  | (e.isPredicted() ? IS_PREDICTED : 0)
+                  | (e.isPrimary() ? IS_PRIMARY : 0);
+
+    write(_stream, flags);
+
+    write(_stream, uint32_t(e.coalescedPointerEvents().size()));
+
+    for (const PointerEventArgs& coalesced : e.coalescedPointerEvents())
+    {
+        _writePointer(coalesced);
+    }
+
+    write(_stream, uint32_t(e.predictedPointerEvents().size()));
+
+    for (const PointerEventArgs& predicted : e.predictedPointerEvents())
+    {
+        _writePointer(predicted);
+    }
+}
+
+
+void InputRecorder::_writeString(const std::string& value)
+{
+    auto iter = _strings.find(value);
+
+    if (iter != _strings.end())
+    {
+        write(_stream, iter->second);
+        return;
+    }
+
+    // A new string is written as the next index followed by its contents.
+    uint32_t index = uint32_t(_strings.size());
+    _strings[value] = index;
+
+    write(_stream, index);
+    write(_stream, uint32_t(value.size()));
+    _stream.write(value.data(), value.size());
+}
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,380 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/InputReplay.h"
+#include "ofx/DOM/Document.h"
+#include "ofx/DOM/InputRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <type_traits>
+
+
+namespace ofx {
+namespace DOM {
+
+
+namespace {
+
+
+/// \brief Read an integer in little-endian byte order.
+template <typename Type>
+Type read(std::istream& stream)
+{
+    typedef typename std::make_unsigned<Type>::type Unsigned;
+
+    unsigned char bytes[sizeof(Type)];
+
+    if (!stream.read(reinterpret_cast<char*>(bytes), sizeof(Type)))
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "InputReplay::load: Unexpected end of stream.");
+    }
+
+    Unsigned bits = 0;
+
+    for (std::size_t i = sizeof(Type); i-- > 0;)
+    {
+        bits = Unsigned((bits << 8) | bytes[i]);
+    }
+
+    return Type(bits);
+}
+
+
+/// \brief Read a float written as its IEEE 754 bits.
+template <>
+float read<float>(std::istream& stream)
+{
+    uint32_t bits = read<uint32_t>(stream);
+
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+const std::string& readString(std::istream& stream, std::vector<std::string>& strings)
+{
+    uint32_t index = read<uint32_t>(stream);
+
+    if (index == strings.size())
+    {
+        // A new string follows its index.
+        std::string value(read<uint32_t>(stream), '\0');
+
+        if (!stream.read(&value[0], value.size()))
+        {
+            throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "InputReplay::load: Unexpected end of stream.");
+        }
+
+        strings.push_back(std::move(value));
+    }
+    else if (index > strings.size())
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "InputReplay::load: Invalid string index.");
+    }
+
+    return strings[index];
+}
+
+
+PointerEventArgs readPointer(std::istream& stream, std::vector<std::string>& strings)
+{
+    std::string eventType = readString(stream, strings);
+    std::string deviceType = readString(stream, strings);
+
+    Position position;
+    position.x = read<float>(stream);
+    position.y = read<float>(stream);
+
+    float pressure = read<float>(stream);
+    float tangentialPressure = read<float>(stream);
+    float twist = read<float>(stream);
+    float tiltX = read<float>(stream);
+    float tiltY = read<float>(stream);
+
+    PointShape::ShapeType shapeType = PointShape::ShapeType(read<uint8_t>(stream));
+    float width = read<float>(stream);
+    float height = read<float>(stream);
+    float widthTolerance = read<float>(stream);
+    float heightTolerance = read<float>(stream);
+    float angle = read<float>(stream);
+
+    uint64_t timestampMicros = read<uint64_t>(stream);
+    uint64_t detail = read<uint64_t>(stream);
+    uint64_t pointerId = read<uint64_t>(stream);
+    int64_t deviceId = read<int64_t>(stream);
+    int64_t pointerIndex = read<int64_t>(stream);
+    uint64_t sequenceIndex = read<uint64_t>(stream);
+    int32_t button = read<int32_t>(stream);
+    int32_t buttons = read<int32_t>(stream);
+    int32_t modifiers = read<int32_t>(stream);
+    uint8_t flags = read<uint8_t>(stream);
+
+    std::vector<PointerEventArgs> coalesced;
+
+    // Grow as events are read, so a corrupt count fails at the end of the
+    // stream rather than allocating.
+    for (uint32_t i = read<uint32_t>(stream); i > 0; --i)
+    {
+        coalesced.push_back(readPointer(stream, strings));
+    }
+
+    std::vector<PointerEventArgs> predicted;
+
+    for (uint32_t i = read<uint32_t>(stream); i > 0; --i)
+    {
+        predicted.push_back(readPointer(stream, strings));
+    }
+
+    Point point(position,
+                PointShape(shapeType, width, height, widthTolerance, heightTolerance, angle),
+                pressure,
+                tangentialPressure,
+                twist,
+                tiltX,
+                tiltY);
+
+    return PointerEventArgs(nullptr,
+                            eventType,
+                            timestampMicros,
+                            detail,
+                            point,
+                            pointerId,
+                            deviceId,
+                            pointerIndex,
+                            sequenceIndex,
+                            deviceType,
+                            (flags & InputRecorder::CAN_HOVER) != 0,
+                            (flags & InputRecorder::IS_COALESCED) != 0,
+                            (flags & InputRecorder::IS_PREDICTED) != 0,
+                            (flags & InputRecorder::IS_PRIMARY) != 0,
+                            button,
+                            buttons,
+                            modifiers,
+                            coalesced,
+                            predicted);
+}
+
+
+uint64_t elapsedMicros(std::chrono::steady_clock::time_point start)
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+}
+
+
+uint64_t elapsedNanos(std::chrono::steady_clock::time_point start)
+{
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+
+} // namespace
+
+
+const uint64_t InputReplay::DEFAULT_FRAME_INTERVAL_MICROS = 16667;
+
+
+std::string InputReplay::Results::toString() const
+{
+    std::stringstream ss;
+    ss << numEvents << " events, " << numFrames << " frames in ";
+    ss << durationMicros << " us (" << eventsPerSecond << " events/s)" << std::endl;
+    ss << "Event latency ns: p50=" << eventLatency.p50 << " p90=" << eventLatency.p90;
+    ss << " p99=" << eventLatency.p99 << " max=" << eventLatency.max << std::endl;
+    ss << "Frame latency ns: p50=" << frameLatency.p50 << " p90=" << frameLatency.p90;
+    ss << " p99=" << frameLatency.p99 << " max=" << frameLatency.max;
+    return ss.str();
+}
+
+
+InputReplay::InputReplay()
+{
+}
+
+
+InputReplay::~InputReplay()
+{
+}
+
+
+void InputReplay::load(std::istream& stream)
+{
+    if (read<uint32_t>(stream) != InputRecorder::MAGIC)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "InputReplay::load: Not an input recording.");
+    }
+
+    if (read<uint32_t>(stream) != InputRecorder::VERSION)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "InputReplay::load: Unsupported recording version.");
+    }
+
+    _records.clear();
+
+    std::vector<std::string> strings;
+
+    // Stop at the end of the stream, but not in the middle of a record.
+    while (stream.peek() != std::char_traits<char>::eof())
+    {
+        Record record;
+
+        uint8_t type = read<uint8_t>(stream);
+        record.timeMicros = read<uint64_t>(stream);
+
+        if (type == InputRecorder::POINTER_RECORD)
+        {
+            record.entry.type = EventQueue::Entry::Type::POINTER;
+            record.entry.pointer = readPointer(stream, strings);
+        }
+        else if (type == InputRecorder::KEY_RECORD)
+        {
+            record.entry.type = EventQueue::Entry::Type::KEY;
+
+            ofKeyEventArgs& key = record.entry.key;
+            key.type = ofKeyEventArgs::Type(read<int32_t>(stream));
+            key.key = read<int32_t>(stream);
+            key.keycode = read<int32_t>(stream);
+            key.scancode = read<int32_t>(stream);
+            key.codepoint = read<uint32_t>(stream);
+            key.modifiers = read<int32_t>(stream);
+            key.isRepeat = read<uint8_t>(stream) != 0;
+        }
+        else
+        {
+            throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "InputReplay::load: Invalid record type.");
+        }
+
+        _records.push_back(std::move(record));
+    }
+}
+
+
+std::size_t InputReplay::size() const
+{
+    return _records.size();
+}
+
+
+uint64_t InputReplay::durationMicros() const
+{
+    return _records.empty() ? 0 : _records.back().timeMicros;
+}
+
+
+InputReplay::Results InputReplay::run(Document& document,
+                                      Mode mode,
+                                      uint64_t frameIntervalMicros)
+{
+    Results results;
+
+    std::vector<uint64_t> eventDurations;
+    std::vector<uint64_t> frameDurations;
+
+    eventDurations.reserve(_records.size());
+
+    // Copy the events, since the Document may modify them.
+    EventQueue::Entry entry;
+
+    ofEventArgs args;
+
+    auto update = [&]()
+    {
+        auto frameStart = std::chrono::steady_clock::now();
+        document.update(args);
+        frameDurations.push_back(elapsedNanos(frameStart));
+    };
+
+    uint64_t nextFrameMicros = frameIntervalMicros;
+
+    auto start = std::chrono::steady_clock::now();
+
+    for (const Record& record : _records)
+    {
+        // Update the frames that ended before this event.
+        while (frameIntervalMicros > 0 && record.timeMicros >= nextFrameMicros)
+        {
+            if (mode == Mode::REAL_TIME)
+            {
+                std::this_thread::sleep_until(start + std::chrono::microseconds(nextFrameMicros));
+            }
+
+            update();
+            nextFrameMicros += frameIntervalMicros;
+        }
+
+        if (mode == Mode::REAL_TIME)
+        {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(record.timeMicros));
+        }
+
+        entry = record.entry;
+
+        auto eventStart = std::chrono::steady_clock::now();
+
+        switch (entry.type)
+        {
+            case EventQueue::Entry::Type::POINTER:
+                document.onPointerEvent(entry.pointer);
+                break;
+            case EventQueue::Entry::Type::KEY:
+                document.onKeyEvent(entry.key);
+                break;
+        }
+
+        eventDurations.push_back(elapsedNanos(eventStart));
+    }
+
+    // Dispatch anything still queued or coalesced.
+    update();
+
+    results.durationMicros = elapsedMicros(start);
+    results.numEvents = eventDurations.size();
+    results.numFrames = frameDurations.size();
+
+    if (results.durationMicros > 0)
+    {
+        results.eventsPerSecond = results.numEvents * 1000000.0 / results.durationMicros;
+    }
+
+    results.eventLatency = _percentiles(eventDurations);
+    results.frameLatency = _percentiles(frameDurations);
+
+    return results;
+}
+
+
+InputReplay::Percentiles InputReplay::_percentiles(std::vector<uint64_t>& durations)
+{
+    Percentiles percentiles;
+
+    if (durations.empty())
+    {
+        return percentiles;
+    }
+
+    std::sort(durations.begin(), durations.end());
+
+    auto at = [&](double fraction)
+    {
+        return durations[std::size_t(fraction * (durations.size() - 1))];
+    };
+
+    percentiles.p50 = at(0.50);
+    percentiles.p90 = at(0.90);
+    percentiles.p99 = at(0.99);
+    percentiles.max = durations.back();
+
+    return percentiles;
+}
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,191 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/MutationObserver.h"
+#include "ofx/DOM/Document.h"
+
+
+namespace ofx {
+namespace DOM {
+
+
+MutationRecord::MutationRecord(Type type, Element* target):
+    _type(type),
+    _target(target)
+{
+}
+
+
+MutationRecord::~MutationRecord()
+{
+}
+
+
+MutationRecord::Type MutationRecord::type() const
+{
+    return _type;
+}
+
+
+Element* MutationRecord::target() const
+{
+    return _target;
+}
+
+
+const std::vector<Element*>& MutationRecord::addedElements() const
+{
+    return _addedElements;
+}
+
+
+const std::vector<Element*>& MutationRecord::removedElements() const
+{
+    return _removedElements;
+}
+
+
+Element* MutationRecord::reorderedElement() const
+{
+    return _reorderedElement;
+}
+
+
+std::size_t MutationRecord::oldIndex() const
+{
+    return _oldIndex;
+}
+
+
+std::size_t MutationRecord::newIndex() const
+{
+    return _newIndex;
+}
+
+
+const std::string& MutationRecord::attributeName() const
+{
+    return _attributeName;
+}
+
+
+MutationObserver::MutationObserver(Callback callback):
+    _callback(callback)
+{
+}
+
+
+MutationObserver::~MutationObserver()
+{
+    disconnect();
+}
+
+
+void MutationObserver::observe(Element* target, const MutationObserverInit& options)
+{
+    Document* document = target != nullptr ? target->document() : nullptr;
+
+    if (document == nullptr)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "MutationObserver::observe: The target is not in a Document.");
+    }
+
+    if (_document != nullptr && _document != document)
+    {
+        throw DOMException(DOMException::INVALID_STATE_ERROR + ": " + "MutationObserver::observe: The target is in a different Document.");
+    }
+
+    for (auto& observed : _targets)
+    {
+        if (observed.first == target)
+        {
+            observed.second = options;
+            return;
+        }
+    }
+
+    _targets.push_back(std::make_pair(target, options));
+
+    if (_document == nullptr)
+    {
+        _document = document;
+        _document->addMutationObserver(this);
+    }
+}
+
+
+void MutationObserver::disconnect()
+{
+    if (_document != nullptr)
+    {
+        _document->removeMutationObserver(this);
+        _document = nullptr;
+    }
+
+    _targets.clear();
+    _records.clear();
+}
+
+
+std::vector<MutationRecord> MutationObserver::takeRecords()
+{
+    std::vector<MutationRecord> records;
+    records.swap(_records);
+    return records;
+}
+
+
+bool MutationObserver::matches(const MutationRecord& record) const
+{
+    for (const auto& observed : _targets)
+    {
+        const MutationObserverInit& options = observed.second;
+
+        bool isObservedType = false;
+
+        switch (record.type())
+        {
+            case MutationRecord::Type::CHILD_LIST:
+                isObservedType = options.childList;
+                break;
+            case MutationRecord::Type::CHILD_ORDER:
+                isObservedType = options.childOrder;
+                break;
+            case MutationRecord::Type::ATTRIBUTES:
+                isObservedType = options.attributes;
+                break;
+        }
+
+        if (!isObservedType)
+        {
+            continue;
+        }
+
+        if (record.target() == observed.first)
+        {
+            return true;
+        }
+
+        if (options.subtree)
+        {
+            for (Element* element = record.target()->parent();
+                 element != nullptr;
+                 element = element->parent())
+            {
+                if (element == observed.first)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,268 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/Selector.h"
+#include "ofx/DOM/Exceptions.h"
+#include <cctype>
+
+
+namespace ofx {
+namespace DOM {
+
+
+namespace {
+
+
+bool isNameCharacter(char c)
+{
+    return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_';
+}
+
+
+} // namespace
+
+
+Selector::Selector(const std::string& selector):
+    _source(selector)
+{
+    _skipWhitespace();
+
+    while (true)
+    {
+        Complex complex;
+        complex.compounds.push_back(_parseCompound());
+
+        while (true)
+        {
+            bool hasWhitespace = _skipWhitespace();
+
+            if (_cursor == _source.size() || _source[_cursor] == ',')
+            {
+                break;
+            }
+
+            if (_source[_cursor] == '>')
+            {
+                ++_cursor;
+                _skipWhitespace();
+                complex.combinators.push_back(Combinator::CHILD);
+            }
+            else if (hasWhitespace)
+            {
+                complex.combinators.push_back(Combinator::DESCENDANT);
+            }
+            else
+            {
+                _error("Unexpected character.");
+            }
+
+            complex.compounds.push_back(_parseCompound());
+        }
+
+        _alternatives.push_back(std::move(complex));
+
+        if (_cursor == _source.size())
+        {
+            break;
+        }
+
+        // Skip the comma.
+        ++_cursor;
+        _skipWhitespace();
+    }
+}
+
+
+Selector::~Selector()
+{
+}
+
+
+const std::string& Selector::source() const
+{
+    return _source;
+}
+
+
+const std::vector<Selector::Complex>& Selector::alternatives() const
+{
+    return _alternatives;
+}
+
+
+void Selector::resolveKeys()
+{
+    if (_numUnresolvedKeys == 0)
+    {
+        return;
+    }
+
+    for (Complex& complex : _alternatives)
+    {
+        for (Compound& compound : complex.compounds)
+        {
+            for (Attribute& attribute : compound.attributes)
+            {
+                if (attribute.key == nullptr)
+                {
+                    attribute.key = AttributeKeyRegistry::findKey(attribute.name);
+
+                    if (attribute.key != nullptr)
+                    {
+                        --_numUnresolvedKeys;
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+Selector::Compound Selector::_parseCompound()
+{
+    Compound compound;
+
+    bool isEmpty = true;
+
+    if (_cursor < _source.size() && _source[_cursor] == '*')
+    {
+        ++_cursor;
+        isEmpty = false;
+    }
+    else if (_cursor < _source.size() && isNameCharacter(_source[_cursor]))
+    {
+        compound.typeTag = _parseName();
+        isEmpty = false;
+    }
+
+    while (_cursor < _source.size())
+    {
+        if (_source[_cursor] == '#')
+        {
+            ++_cursor;
+
+            if (!compound.id.empty())
+            {
+                _error("Multiple ids in a compound selector.");
+            }
+
+            compound.id = _parseName();
+        }
+        else if (_source[_cursor] == '[')
+        {
+            ++_cursor;
+            _skipWhitespace();
+
+            Attribute attribute;
+            attribute.name = _parseName();
+
+            // Selectors must not grow the registry, so unknown names are left
+            // unresolved and match nothing.
+            attribute.key = AttributeKeyRegistry::findKey(attribute.name);
+
+            if (attribute.key == nullptr)
+            {
+                ++_numUnresolvedKeys;
+            }
+
+            _skipWhitespace();
+
+            if (_cursor < _source.size() && _source[_cursor] == '=')
+            {
+                ++_cursor;
+                _skipWhitespace();
+                attribute.hasValue = true;
+                attribute.value = _parseValue();
+                _skipWhitespace();
+            }
+
+            if (_cursor == _source.size() || _source[_cursor] != ']')
+            {
+                _error("Expected ']'.");
+            }
+
+            ++_cursor;
+
+            compound.attributes.push_back(std::move(attribute));
+        }
+        else
+        {
+            break;
+        }
+
+        isEmpty = false;
+    }
+
+    if (isEmpty)
+    {
+        _error("Expected a selector.");
+    }
+
+    return compound;
+}
+
+
+std::string Selector::_parseName()
+{
+    std::size_t start = _cursor;
+
+    while (_cursor < _source.size() && isNameCharacter(_source[_cursor]))
+    {
+        ++_cursor;
+    }
+
+    if (_cursor == start)
+    {
+        _error("Expected a name.");
+    }
+
+    return _source.substr(start, _cursor - start);
+}
+
+
+std::string Selector::_parseValue()
+{
+    if (_cursor < _source.size() && (_source[_cursor] == '"' || _source[_cursor] == '\''))
+    {
+        char quote = _source[_cursor++];
+
+        std::size_t end = _source.find(quote, _cursor);
+
+        if (end == std::string::npos)
+        {
+            _error("Unterminated string.");
+        }
+
+        std::string value = _source.substr(_cursor, end - _cursor);
+        _cursor = end + 1;
+        return value;
+    }
+
+    return _parseName();
+}
+
+
+bool Selector::_skipWhitespace()
+{
+    std::size_t start = _cursor;
+
+    while (_cursor < _source.size() && std::isspace(static_cast<unsigned char>(_source[_cursor])))
+    {
+        ++_cursor;
+    }
+
+    return _cursor != start;
+}
+
+
+void Selector::_error(const std::string& message) const
+{
+    throw DOMException(DOMException::SYNTAX_ERROR + ": " + "Selector::Selector: " + message + " At position " + std::to_string(_cursor) + " in \"" + _source + "\".");
+}
+
+
+} } // namespace ofx::DOM
@@ -0,0 +1,203 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/ShapeKernels.h"
+#include <algorithm>
+
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OFX_DOM_SHAPE_KERNELS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace ofx {
+namespace DOM {
+
+
+namespace {
+
+
+/// \returns the index of the lowest set bit of a non-zero mask.
+inline std::size_t lowestSetBit(int mask)
+{
+    std::size_t index = 0;
+
+    while ((mask & 1) == 0)
+    {
+        mask >>= 1;
+        ++index;
+    }
+
+    return index;
+}
+
+
+} // namespace
+
+
+std::size_t ShapeKernels::findContaining(const float* left,
+                                         const float* top,
+                                         const float* right,
+                                         const float* bottom,
+                                         std::size_t first,
+                                         std::size_t last,
+                                         float x,
+                                         float y)
+{
+    std::size_t i = first;
+
+#if defined(__AVX__)
+    const __m256 px = _mm256_set1_ps(x);
+    const __m256 py = _mm256_set1_ps(y);
+
+    for (; i + 8 <= last; i += 8)
+    {
+        __m256 inside = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(px, _mm256_loadu_ps(left + i), _CMP_GT_OQ),
+                                                    _mm256_cmp_ps(px, _mm256_loadu_ps(right + i), _CMP_LT_OQ)),
+                                      _mm256_and_ps(_mm256_cmp_ps(py, _mm256_loadu_ps(top + i), _CMP_GT_OQ),
+                                                    _mm256_cmp_ps(py, _mm256_loadu_ps(bottom + i), _CMP_LT_OQ)));
+
+        int mask = _mm256_movemask_ps(inside);
+
+        if (mask != 0)
+        {
+            return i + lowestSetBit(mask);
+        }
+    }
+#elif defined(OFX_DOM_SHAPE_KERNELS_SSE2)
+    const __m128 px = _mm_set1_ps(x);
+    const __m128 py = _mm_set1_ps(y);
+
+    for (; i + 4 <= last; i += 4)
+    {
+        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpgt_ps(px, _mm_loadu_ps(left + i)),
+                                              _mm_cmplt_ps(px, _mm_loadu_ps(right + i))),
+                                   _mm_and_ps(_mm_cmpgt_ps(py, _mm_loadu_ps(top + i)),
+                                              _mm_cmplt_ps(py, _mm_loadu_ps(bottom + i))));
+
+        int mask = _mm_movemask_ps(inside);
+
+        if (mask != 0)
+        {
+            return i + lowestSetBit(mask);
+        }
+    }
+#endif
+
+    for (; i < last; ++i)
+    {
+        if (x > left[i] && x < right[i] && y > top[i] && y < bottom[i])
+        {
+            return i;
+        }
+    }
+
+    return last;
+}
+
+
+void ShapeKernels::growToInclude(const float* left,
+                                 const float* top,
+                                 const float* right,
+                                 const float* bottom,
+                                 std::size_t first,
+                                 std::size_t last,
+                                 float& boundsLeft,
+                                 float& boundsTop,
+                                 float& boundsRight,
+                                 float& boundsBottom)
+{
+    std::size_t i = first;
+
+#if defined(__AVX__)
+    if (i + 8 <= last)
+    {
+        __m256 minX = _mm256_set1_ps(boundsLeft);
+        __m256 minY = _mm256_set1_ps(boundsTop);
+        __m256 maxX = _mm256_set1_ps(boundsRight);
+        __m256 maxY = _mm256_set1_ps(boundsBottom);
+
+        for (; i + 8 <= last; i += 8)
+        {
+            minX = _mm256_min_ps(minX, _mm256_loadu_ps(left + i));
+            minY = _mm256_min_ps(minY, _mm256_loadu_ps(top + i));
+            maxX = _mm256_max_ps(maxX, _mm256_loadu_ps(right + i));
+            maxY = _mm256_max_ps(maxY, _mm256_loadu_ps(bottom + i));
+        }
+
+        alignas(32) float lanes[4][8];
+        _mm256_store_ps(lanes[0], minX);
+        _mm256_store_ps(lanes[1], minY);
+        _mm256_store_ps(lanes[2], maxX);
+        _mm256_store_ps(lanes[3], maxY);
+
+        for (std::size_t lane = 0; lane < 8; ++lane)
+        {
+            boundsLeft = std::min(boundsLeft, lanes[0][lane]);
+            boundsTop = std::min(boundsTop, lanes[1][lane]);
+            boundsRight = std::max(boundsRight, lanes[2][lane]);
+            boundsBottom = std::max(boundsBottom, lanes[3][lane]);
+        }
+    }
+#elif defined(OFX_DOM_SHAPE_KERNELS_SSE2)
+    if (i + 4 <= last)
+    {
+        __m128 minX = _mm_set1_ps(boundsLeft);
+        __m128 minY = _mm_set1_ps(boundsTop);
+        __m128 maxX = _mm_set1_ps(boundsRight);
+        __m128 maxY = _mm_set1_ps(boundsBottom);
+
+        for (; i + 4 <= last; i += 4)
+        {
+            minX = _mm_min_ps(minX, _mm_loadu_ps(left + i));
+            minY = _mm_min_ps(minY, _mm_loadu_ps(top + i));
+            maxX = _mm_max_ps(maxX, _mm_loadu_ps(right + i));
+            maxY = _mm_max_ps(maxY, _mm_loadu_ps(bottom + i));
+        }
+
+        alignas(16) float lanes[4][4];
+        _mm_store_ps(lanes[0], minX);
+        _mm_store_ps(lanes[1], minY);
+        _mm_store_ps(lanes[2], maxX);
+        _mm_store_ps(lanes[3], maxY);
+
+        for (std::size_t lane = 0; lane < 4; ++lane)
+        {
+            boundsLeft = std::min(boundsLeft, lanes[0][lane]);
+            boundsTop = std::min(boundsTop, lanes[1][lane]);
+            boundsRight = std::max(boundsRight, lanes[2][lane]);
+            boundsBottom = std::max(boundsBottom, lanes[3][lane]);
+        }
+    }
+#endif
+
+    for (; i < last; ++i)
+    {
+        boundsLeft = std::min(boundsLeft, left[i]);
+        boundsTop = std::min(boundsTop, top[i]);
+        boundsRight = std::max(boundsRight, right[i]);
+        boundsBottom = std::max(boundsBottom, bottom[i]);
+    }
+}
+
+
+const char* ShapeKernels::instructionSet()
+{
+#if defined(__AVX__)
+    return "AVX";
+#elif defined(OFX_DOM_SHAPE_KERNELS_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
+
+
+} } // namespace ofx::DOM
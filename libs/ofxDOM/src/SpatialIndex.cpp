@@ -0,0 +1,320 @@
+//
+// Copyright (c) 2009 Christopher Baker <https://christopherbaker.net>
+//
+// SPDX-License-Identifier:	MIT
+//
+
+
+#include "ofx/DOM/SpatialIndex.h"
+#include "ofx/DOM/Element.h"
+#include <algorithm>
+#include <cmath>
+
+
+namespace ofx {
+namespace DOM {
+
+
+const std::size_t SpatialIndex::DEFAULT_ELEMENTS_PER_CELL = 4;
+const std::size_t SpatialIndex::MAX_CELLS_PER_AXIS = 256;
+
+
+SpatialIndex::SpatialIndex(Element* parent, std::size_t elementsPerCell):
+    _parent(parent),
+    _elementsPerCell(std::max(elementsPerCell, std::size_t(1)))
+{
+}
+
+
+SpatialIndex::~SpatialIndex()
+{
+}
+
+
+Element* SpatialIndex::parent()
+{
+    return _parent;
+}
+
+
+void SpatialIndex::invalidate()
+{
+    _invalid = true;
+}
+
+
+void SpatialIndex::invalidate(const Element* child)
+{
+    // A full rebuild will pick up the change anyway.
+    if (_invalid)
+    {
+        return;
+    }
+
+    // The index is valid, so the child's stored index matches the grid.
+    if (child && child->_parent == _parent && !_isStale[child->_childIndex])
+    {
+        _isStale[child->_childIndex] = true;
+        _stale.push_back(child->_childIndex);
+    }
+}
+
+
+void SpatialIndex::moveChild(std::size_t oldIndex, std::size_t newIndex)
+{
+    // A full rebuild will pick up the new order anyway.
+    if (_invalid || oldIndex == newIndex)
+    {
+        return;
+    }
+
+    _remove(oldIndex);
+
+    // Renumber in the direction of the shift so that each cell stays sorted
+    // and no two children share an index.
+    if (oldIndex < newIndex)
+    {
+        for (std::size_t index = oldIndex + 1; index <= newIndex; ++index)
+        {
+            _renumber(index, index - 1);
+        }
+
+        std::rotate(_shapes.begin() + oldIndex, _shapes.begin() + oldIndex + 1, _shapes.begin() + newIndex + 1);
+        std::rotate(_isStale.begin() + oldIndex, _isStale.begin() + oldIndex + 1, _isStale.begin() + newIndex + 1);
+    }
+    else
+    {
+        for (std::size_t index = oldIndex; index-- > newIndex;)
+        {
+            _renumber(index, index + 1);
+        }
+
+        std::rotate(_shapes.begin() + newIndex, _shapes.begin() + oldIndex, _shapes.begin() + oldIndex + 1);
+        std::rotate(_isStale.begin() + newIndex, _isStale.begin() + oldIndex, _isStale.begin() + oldIndex + 1);
+    }
+
+    _insert(newIndex);
+
+    for (std::size_t& index : _stale)
+    {
+        if (index == oldIndex)
+        {
+            index = newIndex;
+        }
+        else if (oldIndex < index && index <= newIndex)
+        {
+            --index;
+        }
+        else if (newIndex <= index && index < oldIndex)
+        {
+            ++index;
+        }
+    }
+}
+
+
+bool SpatialIndex::isValid() const
+{
+    return !_invalid;
+}
+
+
+const std::vector<std::size_t>& SpatialIndex::query(const Position& localPosition)
+{
+    if (_invalid)
+    {
+        _rebuild();
+    }
+    else if (!_stale.empty())
+    {
+        _updateStale();
+    }
+
+    if (_cells.empty())
+    {
+        return _empty;
+    }
+
+    return _cells[_row(localPosition.y) * _columns + _column(localPosition.x)];
+}
+
+
+void SpatialIndex::_rebuild()
+{
+    _invalid = false;
+    _stale.clear();
+
+    if (_parent == nullptr || _parent->_children.empty())
+    {
+        _shapes.clear();
+        _isStale.clear();
+        _cells.clear();
+        _columns = 0;
+        _rows = 0;
+        return;
+    }
+
+    const auto& children = _parent->_children;
+
+    _shapes.resize(children.size());
+    _isStale.assign(children.size(), false);
+
+    for (std::size_t i = 0; i < children.size(); ++i)
+    {
+        _shapes[i] = children[i]->getTotalShape();
+
+        if (i == 0)
+        {
+            _bounds = _shapes[i];
+        }
+        else
+        {
+            _bounds.growToInclude(_shapes[i]);
+        }
+    }
+
+    // Choose a grid with roughly _elementsPerCell children per cell and
+    // cells that roughly match the aspect ratio of the bounds.
+    float width = std::max(_bounds.getWidth(), 1.0f);
+    float height = std::max(_bounds.getHeight(), 1.0f);
+    float cellCount = std::ceil(float(children.size()) / _elementsPerCell);
+
+    _columns = std::size_t(std::round(std::sqrt(cellCount * width / height)));
+    _columns = std::min(std::max(_columns, std::size_t(1)), MAX_CELLS_PER_AXIS);
+    _rows = std::size_t(std::ceil(cellCount / _columns));
+    _rows = std::min(std::max(_rows, std::size_t(1)), MAX_CELLS_PER_AXIS);
+
+    _cellWidth = width / _columns;
+    _cellHeight = height / _rows;
+
+    // Reuse the existing cell allocations where possible.
+    _cells.resize(_columns * _rows);
+
+    for (auto& cell : _cells)
+    {
+        cell.clear();
+    }
+
+    // Children are inserted front to back, so each cell stays sorted.
+    for (std::size_t i = 0; i < children.size(); ++i)
+    {
+        _insert(i);
+    }
+}
+
+
+void SpatialIndex::_updateStale()
+{
+    for (std::size_t index : _stale)
+    {
+        _remove(index);
+        _shapes[index] = _parent->_children[index]->getTotalShape();
+        _insert(index);
+        _isStale[index] = false;
+    }
+
+    _stale.clear();
+}
+
+
+void SpatialIndex::_insert(std::size_t index)
+{
+    std::size_t column0, row0, column1, row1;
+    _cellRange(_shapes[index], column0, row0, column1, row1);
+
+    for (std::size_t row = row0; row <= row1; ++row)
+    {
+        for (std::size_t column = column0; column <= column1; ++column)
+        {
+            auto& cell = _cells[row * _columns + column];
+            cell.insert(std::lower_bound(cell.begin(), cell.end(), index), index);
+        }
+    }
+}
+
+
+void SpatialIndex::_remove(std::size_t index)
+{
+    std::size_t column0, row0, column1, row1;
+    _cellRange(_shapes[index], column0, row0, column1, row1);
+
+    for (std::size_t row = row0; row <= row1; ++row)
+    {
+        for (std::size_t column = column0; column <= column1; ++column)
+        {
+            auto& cell = _cells[row * _columns + column];
+            auto iter = std::lower_bound(cell.begin(), cell.end(), index);
+
+            if (iter != cell.end() && *iter == index)
+            {
+                cell.erase(iter);
+            }
+        }
+    }
+}
+
+
+void SpatialIndex::_renumber(std::size_t oldIndex, std::size_t newIndex)
+{
+    std::size_t column0, row0, column1, row1;
+    _cellRange(_shapes[oldIndex], column0, row0, column1, row1);
+
+    for (std::size_t row = row0; row <= row1; ++row)
+    {
+        for (std::size_t column = column0; column <= column1; ++column)
+        {
+            auto& cell = _cells[row * _columns + column];
+            auto iter = std::lower_bound(cell.begin(), cell.end(), oldIndex);
+
+            if (iter != cell.end() && *iter == oldIndex)
+            {
+                *iter = newIndex;
+            }
+        }
+    }
+}
+
+
+void SpatialIndex::_cellRange(const Shape& shape,
+                              std::size_t& column0,
+                              std::size_t& row0,
+                              std::size_t& column1,
+                              std::size_t& row1) const
+{
+    // Shapes that extend past the bounds are clamped to the edge cells. Since
+    // queries are clamped the same way, the grid stays correct as children
+    // move outside of the bounds; it only becomes less selective.
+    column0 = _column(shape.getMinX());
+    column1 = _column(shape.getMaxX());
+    row0 = _row(shape.getMinY());
+    row1 = _row(shape.getMaxY());
+}
+
+
+std::size_t SpatialIndex::_column(float x) const
+{
+    float column = std::floor((x - _bounds.getMinX()) / _cellWidth);
+
+    if (!(column > 0))
+    {
+        return 0;
+    }
+
+    return std::size_t(std::min(column, float(_columns - 1)));
+}
+
+
+std::size_t SpatialIndex::_row(float y) const
+{
+    float row = std::floor((y - _bounds.getMinY()) / _cellHeight);
+
+    if (!(row > 0))
+    {
+        return 0;
+    }
+
+    return std::size_t(std::min(row, float(_rows - 1)));
+}
+
+
+} } // namespace ofx::DOM